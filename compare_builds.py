@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Build sum_experiment as baseline, LTO, PGO and LTO+PGO variants and compare them per method."""
+import argparse
+import csv
+import os
+import statistics
+import subprocess
+import sys
+
+VARIANTS = {
+    "baseline": {"lto": False, "pgo": False},
+    "lto":      {"lto": True,  "pgo": False},
+    "pgo":      {"lto": False, "pgo": True},
+    "lto_pgo":  {"lto": True,  "pgo": True},
+}
+
+
+def run(cmd, cwd=None):
+    print("+", " ".join(cmd))
+    subprocess.run(cmd, cwd=cwd, check=True)
+
+
+def configure(args, build_dir, lto, pgo_stage):
+    run([args.cmake, "-S", args.source, "-B", build_dir,
+         "-DCMAKE_BUILD_TYPE=Release",
+         "-DCMAKE_CXX_COMPILER=" + args.cxx,
+         "-DSUM_ENABLE_LTO=" + ("ON" if lto else "OFF"),
+         "-DSUM_PGO=" + pgo_stage])
+
+
+def build(args, build_dir, target=None):
+    cmd = [args.cmake, "--build", build_dir, "--config", "Release"]
+    if target:
+        cmd += ["--target", target]
+    run(cmd)
+
+
+def build_variant(args, name, opts):
+    build_dir = os.path.join(args.build_root, name)
+    if opts["pgo"]:
+        configure(args, build_dir, opts["lto"], "GENERATE")
+        build(args, build_dir)
+        build(args, build_dir, "pgo_train")
+        configure(args, build_dir, opts["lto"], "USE")
+    else:
+        configure(args, build_dir, opts["lto"], "OFF")
+    build(args, build_dir)
+    exe = "sum_experiment.exe" if os.name == "nt" else "sum_experiment"
+    for candidate in (os.path.join(build_dir, exe), os.path.join(build_dir, "Release", exe)):
+        if os.path.isfile(candidate):
+            return candidate
+    sys.exit("Could not find the built binary for variant " + name)
+
+
+def list_methods(binary):
+    """Every method the binary accepts, from its --list-methods output."""
+    out = subprocess.run([binary, "--list-methods"], check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return out.split()
+
+
+def median_time(binary, method, args):
+    workdir = os.path.join(args.build_root, "runs")
+    os.makedirs(workdir, exist_ok=True)
+    run([binary, "--threads", args.threads, "--size", str(args.size), "--method", method,
+         "--runs", str(args.runs), "--warmup", "1", "--dist", "rand"], cwd=workdir)
+    with open(os.path.join(workdir, "results.csv")) as f:
+        times = [float(row["Time_ms"]) for row in csv.DictReader(f)]
+    return statistics.median(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--source", required=True)
+    parser.add_argument("--build-root", required=True)
+    parser.add_argument("--cmake", default="cmake")
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("--threads", default="4")
+    parser.add_argument("--size", type=int, default=20000000)
+    parser.add_argument("--runs", type=int, default=7)
+    args = parser.parse_args()
+
+    binaries = {name: build_variant(args, name, opts) for name, opts in VARIANTS.items()}
+    methods = list_methods(binaries["baseline"])
+    times = {name: {m: median_time(binary, m, args) for m in methods} for name, binary in binaries.items()}
+
+    print("\nMedian time (ms) and speedup over baseline, threads=%s size=%d" % (args.threads, args.size))
+    print("%-13s" % "Method" + "".join("%20s" % name for name in VARIANTS))
+    for m in methods:
+        base = times["baseline"][m]
+        cells = ["%9.3f (%5.2fx)" % (times[name][m], base / times[name][m] if times[name][m] > 0 else 0.0)
+                 for name in VARIANTS]
+        print("%-13s" % m + "".join("%20s" % c for c in cells))
+
+
+if __name__ == "__main__":
+    main()
@@ -42,10 +42,13 @@
 #include <sstream>
 #include <ostream>
 #include <utility>
+#include <cstdint>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <random>
 #include <chrono>
+#include <thread>
 #include <atomic>
 #include <regex>
 #include <array>
@@ -573,6 +576,113 @@ private:
     arguments          args_accepted_;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////// zen::combinable
+
+// Per-thread accumulators for parallel code, use like this:
+// 
+// zen::combinable<long long> sums;
+// ... in each parallel task:  sums.local() += partial;
+// ... after the parallel region has been joined:
+// const long long total = sums.combine(std::plus<>());
+// 
+// Each thread's slot is created on its first local() call and sits on its own cache line(s),
+// so threads never write to a line another thread writes to. local() may be called concurrently
+// from any number of threads; combine(), combine_each() and clear() must not race with local().
+template<class T>
+class combinable {
+public:
+    combinable() : combinable([]() { return T(); }) {}
+
+    template<class Init>
+    explicit combinable(Init init) : init_(std::move(init)), id_(next_id()) {}
+
+    combinable(const combinable&)            = delete;
+    combinable& operator=(const combinable&) = delete;
+
+    ~combinable() { clear_slots(); }
+
+    // The calling thread's slot, initialized with the init function on first use
+    T& local()
+    {
+        thread_local std::uint64_t cached_id   = 0;
+        thread_local slot*         cached_slot = nullptr;
+        if (cached_id == id_)
+            return cached_slot->value;
+
+        // Only this thread ever adds a slot owned by this thread, so the search can't miss one being added
+        const std::thread::id me = std::this_thread::get_id();
+        slot* s = head_.load(std::memory_order_acquire);
+        while (s && s->owner != me)
+            s = s->next;
+        if (!s) {
+            s = new slot{init_(), me, head_.load(std::memory_order_relaxed)};
+            while (!head_.compare_exchange_weak(s->next, s, std::memory_order_release, std::memory_order_relaxed)) {}
+        }
+        cached_id   = id_;
+        cached_slot = s;
+        return s->value;
+    }
+
+    // Folds every thread's slot with op; the init value if no thread has called local()
+    template<class Op>
+    T combine(Op op) const
+    {
+        const slot* s = head_.load(std::memory_order_acquire);
+        if (!s)
+            return init_();
+
+        T result = s->value;
+        for (s = s->next; s; s = s->next)
+            result = op(result, s->value);
+        return result;
+    }
+
+    template<class F>
+    void combine_each(F f) const
+    {
+        for (const slot* s = head_.load(std::memory_order_acquire); s; s = s->next)
+            f(s->value);
+    }
+
+    // Drops every slot; threads get fresh slots on their next local() call
+    void clear()
+    {
+        clear_slots();
+        id_ = next_id();
+    }
+
+private:
+    // 128 bytes covers both a 64-byte line and the adjacent line that spatial prefetchers pull in with it
+    static constexpr std::size_t slot_alignment = 128;
+
+    struct alignas(slot_alignment) slot {
+        T               value;
+        std::thread::id owner;
+        slot*           next;
+    };
+
+    // Ids are never reused, so a thread's cached slot can't outlive its combinable unnoticed
+    static std::uint64_t next_id()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    void clear_slots()
+    {
+        slot* s = head_.exchange(nullptr, std::memory_order_acquire);
+        while (s) {
+            slot* next = s->next;
+            delete s;
+            s = next;
+        }
+    }
+
+    std::function<T()>  init_;
+    std::uint64_t       id_;
+    std::atomic<slot*>  head_{nullptr};
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////// CONCEPTS
 
 // ------------------------------------------------------------------------------------------ HasEmpty
@@ -10,9 +10,47 @@
 #include <algorithm>
 #include <random>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <queue>
 #include <future>
 #include <functional>
+#include <filesystem>
+#include <iomanip>
+#include <memory>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <csignal>
+#include <ctime>
+#include <cerrno>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <ucontext.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // For C++17 parallel algorithm
 #ifdef __cpp_lib_execution
@@ -21,163 +59,4945 @@
 
 #include "kaizen.h"
 
-// ------------------ Simple Thread Pool Implementation ---------------------
-class ThreadPool {
+// ------------------ CPU Placement Helpers ---------------------------------
+// Pins a thread to one CPU core. Returns false if pinning is unsupported or fails.
+bool pinThreadToCore(std::thread& thread, int core) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)thread; (void)core;
+    return false;
+#endif
+}
+
+// Returns the ids of the CPUs this process may run on.
+std::vector<int> availableCores() {
+    std::vector<int> cores;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &set)) cores.push_back(c);
+    }
+#endif
+    if (cores.empty()) {
+        for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); ++c)
+            cores.push_back(static_cast<int>(c));
+    }
+    return cores;
+}
+
+// ------------------ cgroup CPU Quota Awareness -----------------------------
+// Candidate directories of this process's CPU cgroup: the cgroup v1 "cpu" controller first, then cgroup v2.
+// Inside a container the cgroup path is usually namespaced, so the mount roots are tried as well.
+std::vector<std::filesystem::path> cpuCgroupDirs() {
+    std::vector<std::filesystem::path> dirs;
+#if defined(__linux__)
+    const std::filesystem::path root = "/sys/fs/cgroup";
+    std::ifstream cgroup_file("/proc/self/cgroup");
+    std::string line;
+    std::vector<std::filesystem::path> v2_dirs;
+    while (std::getline(cgroup_file, line)) {
+        // Format: hierarchy-id:controller-list:path
+        const size_t first = line.find(':'), second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) continue;
+        const std::string controllers = line.substr(first + 1, second - first - 1);
+        const std::string path = line.substr(second + 1);
+        if (controllers.empty()) {
+            for (const std::filesystem::path& mount : {root, root / "unified"}) {
+                v2_dirs.push_back(mount / std::filesystem::path(path).relative_path());
+                v2_dirs.push_back(mount);
+            }
+            continue;
+        }
+        std::stringstream ss(controllers);
+        std::string controller;
+        while (std::getline(ss, controller, ',')) {
+            if (controller == "cpu") {
+                dirs.push_back(root / controllers / std::filesystem::path(path).relative_path());
+                dirs.push_back(root / controllers);
+            }
+        }
+    }
+    dirs.insert(dirs.end(), v2_dirs.begin(), v2_dirs.end());
+#endif
+    return dirs;
+}
+
+// Quota of one cgroup directory in cores (cgroup v2 cpu.max or v1 cfs quota/period), or 0 if it sets none.
+double cgroupDirCpuLimit(const std::filesystem::path& dir) {
+    std::error_code ec;
+    if (std::filesystem::exists(dir / "cpu.max", ec)) {
+        std::ifstream f(dir / "cpu.max");
+        std::string quota;
+        double period = 0;
+        if (f >> quota >> period && quota != "max" && period > 0)
+            return std::stod(quota) / period;
+        return 0.0;
+    }
+    if (std::filesystem::exists(dir / "cpu.cfs_quota_us", ec)) {
+        std::ifstream quota_file(dir / "cpu.cfs_quota_us"), period_file(dir / "cpu.cfs_period_us");
+        double quota = -1, period = 0;
+        if (quota_file >> quota && period_file >> period && quota > 0 && period > 0)
+            return quota / period;
+    }
+    return 0.0;
+}
+
+// The effective cgroup CPU quota and the cgroup directory that sets it.
+struct CpuLimit {
+    double cores = 0.0;         // 0 if unlimited or unknown
+    std::filesystem::path dir;  // empty without a quota
+};
+
+// Returns the effective cgroup CPU quota. A quota on any ancestor also limits this cgroup, and a leaf
+// often says "max" under a limited parent, so every directory up to the cgroup mount root is read and
+// the smallest quota wins.
+CpuLimit cgroupCpuLimit() {
+    const std::filesystem::path root = "/sys/fs/cgroup";
+    CpuLimit limit;
+    for (std::filesystem::path dir : cpuCgroupDirs()) {
+        while (true) {
+            const double quota = cgroupDirCpuLimit(dir);
+            if (quota > 0 && (limit.cores == 0.0 || quota < limit.cores)) limit = {quota, dir};
+            if (dir == root || !dir.has_relative_path() || dir.parent_path() == dir) break;
+            dir = dir.parent_path();
+        }
+    }
+    return limit;
+}
+
+// CFS throttling counters from the cgroup's cpu.stat.
+struct ThrottleStats {
+    long long nr_throttled = -1; // -1 when no counters are readable
+    double throttled_ms = 0.0;
+    bool valid() const { return nr_throttled >= 0; }
+};
+
+// Reads cpu.stat of the cgroup whose quota cgroupCpuLimit picked, since that is the one the CFS throttles;
+// a "max" leaf below it never counts a throttled period. Without a quota, the first readable cpu.stat is used.
+ThrottleStats readThrottleStats() {
+    static const std::filesystem::path quota_dir = cgroupCpuLimit().dir;
+    std::vector<std::filesystem::path> dirs = cpuCgroupDirs();
+    if (!quota_dir.empty()) dirs = {quota_dir};
+    std::error_code ec;
+    for (const std::filesystem::path& dir : dirs) {
+        if (!std::filesystem::exists(dir / "cpu.stat", ec)) continue;
+        std::ifstream f(dir / "cpu.stat");
+        ThrottleStats stats;
+        std::string key;
+        long long value;
+        while (f >> key >> value) {
+            if (key == "nr_throttled")        stats.nr_throttled = value;
+            else if (key == "throttled_usec") stats.throttled_ms = value / 1e3; // cgroup v2
+            else if (key == "throttled_time") stats.throttled_ms = value / 1e6; // cgroup v1, in ns
+        }
+        if (stats.valid()) return stats;
+    }
+    return {};
+}
+
+// Default worker count: the CPUs in our affinity mask, capped by the cgroup CPU quota.
+// hardware_concurrency() reports the host's cores, which oversubscribes a quota-limited container.
+// A fractional quota is rounded down (at least 1): 2.5 cores gives 2 workers, because a third worker
+// would only fit in the leftover half core by getting the whole group throttled every period.
+int defaultParallelism() {
+    int cores = static_cast<int>(availableCores().size());
+    const double quota = cgroupCpuLimit().cores;
+    if (quota > 0)
+        cores = std::min(cores, std::max(1, static_cast<int>(quota)));
+    return std::max(1, cores);
+}
+
+// ------------------ CPU Frequency ------------------------------------------
+// Scaling governor of the first CPU in our affinity mask, or "unknown" without cpufreq.
+std::string cpuGovernor() {
+    const std::vector<int> cores = availableCores();
+    std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(cores.empty() ? 0 : cores.front()) + "/cpufreq/scaling_governor");
+    std::string governor;
+    return (f >> governor) ? governor : "unknown";
+}
+
+// Mean current frequency (MHz) of the CPUs in our affinity mask, from cpufreq's scaling_cur_freq or
+// else /proc/cpuinfo. On recent x86 kernels both report APERF/MPERF over the last few milliseconds.
+// Returns 0 when neither is readable; source names the one used.
+double sampledCpuMhz(std::string& source) {
+    const std::vector<int> cores = availableCores();
+    double total = 0.0;
+    int readable = 0;
+    for (int core : cores) {
+        std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(core) + "/cpufreq/scaling_cur_freq");
+        double khz;
+        if (f >> khz) { total += khz / 1e3; ++readable; }
+    }
+    if (readable > 0) {
+        source = "cpufreq";
+        return total / readable;
+    }
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    int processor = -1;
+    for (std::string line; std::getline(cpuinfo, line);) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        const std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        try {
+            if (key == "processor") {
+                processor = std::stoi(line.substr(colon + 1));
+            } else if (key == "cpu MHz" && std::find(cores.begin(), cores.end(), processor) != cores.end()) {
+                total += std::stod(line.substr(colon + 1));
+                ++readable;
+            }
+        } catch (...) {}
+    }
+    source = readable > 0 ? "cpuinfo" : "none";
+    return readable > 0 ? total / readable : 0.0;
+}
+
+// Counts CPU cycles and task CPU time of the calling thread and of every thread it creates while
+// open (inherited perf events; counts of a child are added when it exits). Threads that already
+// existed when it was opened are not counted, so it only suits runs with a fresh pool.
+class CycleCounter {
+public:
+    CycleCounter() {
+#if defined(__linux__)
+        cycles = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false);
+        // perf_event_paranoid >= 2 only allows user-mode counting
+        if (cycles < 0) cycles = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true);
+        if (cycles >= 0) task_clock = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, false);
+#endif
+    }
+    ~CycleCounter() {
+#if defined(__linux__)
+        if (cycles >= 0) close(cycles);
+        if (task_clock >= 0) close(task_clock);
+#endif
+    }
+    CycleCounter(const CycleCounter&) = delete;
+    CycleCounter& operator=(const CycleCounter&) = delete;
+
+    bool valid() const { return cycles >= 0 && task_clock >= 0; }
+
+    // Cycles per second of CPU time so far, in MHz; 0 if unavailable
+    double effective_mhz() const {
+#if defined(__linux__)
+        long long cycle_count = 0, task_ns = 0;
+        if (!valid() || ::read(cycles, &cycle_count, sizeof(cycle_count)) != sizeof(cycle_count) ||
+            ::read(task_clock, &task_ns, sizeof(task_ns)) != sizeof(task_ns) || task_ns <= 0)
+            return 0.0;
+        return cycle_count * 1e3 / task_ns;
+#else
+        return 0.0;
+#endif
+    }
+
+private:
+#if defined(__linux__)
+    static int open(uint32_t type, uint64_t config, bool user_only) {
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.inherit = 1;
+        attr.exclude_kernel = user_only ? 1 : 0;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+    int cycles = -1;
+    int task_clock = -1;
+};
+
+// ------------------ Cooperative Cancellation -------------------------------
+// Thrown into the future of a cancellable task whose token fired before the task started.
+struct OperationCancelled : std::runtime_error {
+    OperationCancelled() : std::runtime_error("operation cancelled") {}
+};
+
+// Cancellation state shared between a caller and the tasks working for it. It fires when cancel()
+// is called or once the optional deadline passes; workers poll it at chunk boundaries.
+class CancellationToken {
+public:
+    using clock = std::chrono::steady_clock;
+
+    CancellationToken() : state(State::Active), deadline(clock::time_point::max()) {}
+
+    void cancel() {
+        State expected = State::Active;
+        state.compare_exchange_strong(expected, State::Cancelled, std::memory_order_release);
+    }
+
+    void set_deadline(clock::time_point when) { deadline = when; }
+
+    bool is_cancelled() const {
+        if (state.load(std::memory_order_acquire) != State::Active) return true;
+        if (deadline != clock::time_point::max() && clock::now() >= deadline) {
+            State expected = State::Active;
+            state.compare_exchange_strong(expected, State::DeadlineExceeded, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    bool deadline_exceeded() const { return state.load(std::memory_order_acquire) == State::DeadlineExceeded; }
+
+private:
+    enum class State { Active, Cancelled, DeadlineExceeded };
+    mutable std::atomic<State> state;
+    clock::time_point deadline;
+};
+
+// ------------------ Sampling Profiler --------------------------------------
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SUM_HAS_PROFILER 1
+#endif
+
+constexpr int kProfileDepth = 48;
+
+// One captured stack, leaf first.
+struct ProfileSample {
+    int depth = 0;
+    void* frames[kProfileDepth];
+};
+
+// Outcome of one profiling session.
+struct ProfileReport {
+    long long samples = 0;
+    long long dropped = 0;       // samples that arrived after the buffer filled up
+    double handler_ms = 0.0;     // time spent inside the signal handler
+    double sampled_cpu_ms = 0.0; // CPU time the samples stand for (one timer period each)
+};
+
+// In-process sampling profiler. Every registered thread gets a timer on its own CPU-time clock that
+// sends SIGPROF to that thread only; the handler walks the frame-pointer chain of the interrupted
+// context into a preallocated buffer, claiming a slot with one atomic increment. Stacks are only
+// complete in builds with frame pointers (SUM_FRAME_POINTERS). Linux on x86-64/AArch64 only;
+// start() returns false elsewhere.
+class SamplingProfiler {
+public:
+    static bool start(int hz, size_t capacity) {
+#if defined(SUM_HAS_PROFILER)
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (active || hz <= 0) return false;
+        buffer.assign(capacity, ProfileSample());
+        next = 0;
+        dropped = 0;
+        handler_ns = 0;
+        period_ns = 1000000000LL / hz;
+        struct sigaction action {};
+        action.sa_sigaction = handler;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0) return false;
+        active = true;
+        for (ThreadEntry& entry : threads) arm(entry);
+        return true;
+#else
+        (void)hz; (void)capacity;
+        return false;
+#endif
+    }
+
+    static ProfileReport stop() {
+        ProfileReport report;
+#if defined(SUM_HAS_PROFILER)
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (!active) return report;
+        for (ThreadEntry& entry : threads) disarm(entry);
+        // Ignoring the signal also discards any that are still pending
+        signal(SIGPROF, SIG_IGN);
+        active = false;
+        report.samples = static_cast<long long>(std::min(next.load(), buffer.size()));
+        report.dropped = dropped.load();
+        report.handler_ms = handler_ns.load() / 1e6;
+        report.sampled_cpu_ms = (report.samples + report.dropped) * (period_ns / 1e6);
+#endif
+        return report;
+    }
+
+    // Writes the last session's samples as folded stacks ("root;outer;...;leaf count") for flamegraph tools.
+    static bool write_folded(const std::string& path, const std::string& root) {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+#if defined(SUM_HAS_PROFILER)
+        std::map<void*, std::string> names;
+        auto name = [&names](void* address) -> const std::string& {
+            auto it = names.find(address);
+            if (it != names.end()) return it->second;
+            std::ostringstream label;
+            Dl_info info;
+            if (dladdr(address, &info) && info.dli_sname) {
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                label << (status == 0 && demangled ? demangled : info.dli_sname);
+                std::free(demangled);
+            } else if (dladdr(address, &info) && info.dli_fname) {
+                label << std::filesystem::path(info.dli_fname).filename().string() << "+0x" << std::hex
+                      << reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+            } else {
+                label << "0x" << std::hex << reinterpret_cast<uintptr_t>(address);
+            }
+            std::string text = label.str();
+            std::replace(text.begin(), text.end(), ';', ':');
+            return names.emplace(address, text).first->second;
+        };
+        std::map<std::string, long long> stacks;
+        const size_t count = std::min(next.load(), buffer.size());
+        for (size_t s = 0; s < count; ++s) {
+            const ProfileSample& sample = buffer[s];
+            // Without frame pointers the walk can pick up stray stack words; cut the stack at the
+            // first caller that does not resolve to any loaded object
+            int depth = 1;
+            Dl_info info;
+            while (depth < sample.depth && dladdr(sample.frames[depth], &info)) ++depth;
+            std::string stack = root;
+            for (int d = depth - 1; d >= 0; --d) stack += ";" + name(sample.frames[d]);
+            ++stacks[stack];
+        }
+        for (const auto& [stack, samples] : stacks) out << stack << " " << samples << "\n";
+#else
+        (void)root;
+#endif
+        return true;
+    }
+
+    // Allows threads to register from now on. Until then register_thread() and unregister_thread()
+    // return at once, so pool workers cost nothing when profiling is off.
+    static void enable() {
+#if defined(SUM_HAS_PROFILER)
+        enabled.store(true, std::memory_order_release);
+#endif
+    }
+
+    // Makes the calling thread eligible for sampling until unregister_thread(), if enable() was called.
+    static void register_thread() {
+#if defined(SUM_HAS_PROFILER)
+        if (!enabled.load(std::memory_order_acquire)) return;
+        registered = true;
+        pthread_attr_t attr;
+        if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+            void* low = nullptr;
+            size_t size = 0;
+            if (pthread_attr_getstack(&attr, &low, &size) == 0)
+                stack_high = reinterpret_cast<uintptr_t>(low) + size;
+            pthread_attr_destroy(&attr);
+        }
+        ThreadEntry entry{static_cast<pid_t>(syscall(SYS_gettid)), CLOCK_THREAD_CPUTIME_ID, timer_t(), false};
+        pthread_getcpuclockid(pthread_self(), &entry.clock);
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        threads.push_back(entry);
+        if (active) arm(threads.back());
+#endif
+    }
+
+    static void unregister_thread() {
+#if defined(SUM_HAS_PROFILER)
+        if (!registered) return;
+        registered = false;
+        const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto it = std::find_if(threads.begin(), threads.end(), [tid](const ThreadEntry& e) { return e.tid == tid; });
+        if (it == threads.end()) return;
+        disarm(*it);
+        threads.erase(it);
+#endif
+    }
+
+private:
+#if defined(SUM_HAS_PROFILER)
+    struct ThreadEntry {
+        pid_t tid;
+        clockid_t clock; // the thread's CPU-time clock, so idle threads are not sampled
+        timer_t timer;
+        bool armed;
+    };
+
+    // Both require registry_mutex to be held
+    static void arm(ThreadEntry& entry) {
+        sigevent event {};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event._sigev_un._tid = entry.tid;
+        if (timer_create(entry.clock, &event, &entry.timer) != 0) return;
+        itimerspec spec {};
+        spec.it_interval.tv_sec = period_ns / 1000000000LL;
+        spec.it_interval.tv_nsec = period_ns % 1000000000LL;
+        spec.it_value = spec.it_interval;
+        timer_settime(entry.timer, 0, &spec, nullptr);
+        entry.armed = true;
+    }
+
+    static void disarm(ThreadEntry& entry) {
+        if (entry.armed) timer_delete(entry.timer);
+        entry.armed = false;
+    }
+
+    // Async-signal-safe: no locks or allocation, only atomics and reads of the current stack.
+    static void handler(int, siginfo_t*, void* context) {
+        const int saved_errno = errno;
+        timespec begin, end;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        const size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        if (slot < buffer.size()) {
+            const auto* uc = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__)
+            const uintptr_t pc = uc->uc_mcontext.gregs[REG_RIP], sp = uc->uc_mcontext.gregs[REG_RSP];
+            uintptr_t fp = uc->uc_mcontext.gregs[REG_RBP];
+#else
+            const uintptr_t pc = uc->uc_mcontext.pc, sp = uc->uc_mcontext.sp;
+            uintptr_t fp = uc->uc_mcontext.regs[29];
+#endif
+            ProfileSample& sample = buffer[slot];
+            int depth = 0;
+            sample.frames[depth++] = reinterpret_cast<void*>(pc);
+            // Only follow frame pointers that stay inside the live part of this thread's stack and move outwards
+            while (depth < kProfileDepth && fp >= sp && fp + 2 * sizeof(uintptr_t) <= stack_high && fp % sizeof(uintptr_t) == 0) {
+                const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+                if (frame[1] == 0) break;
+                sample.frames[depth++] = reinterpret_cast<void*>(frame[1] - 1); // inside the call instruction
+                if (frame[0] <= fp) break;
+                fp = frame[0];
+            }
+            sample.depth = depth;
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        handler_ns.fetch_add((end.tv_sec - begin.tv_sec) * 1000000000LL + (end.tv_nsec - begin.tv_nsec), std::memory_order_relaxed);
+        errno = saved_errno;
+    }
+
+    inline static std::mutex registry_mutex;
+    inline static std::vector<ThreadEntry> threads;
+    inline static std::vector<ProfileSample> buffer;
+    inline static std::atomic<size_t> next{0};
+    inline static std::atomic<long long> dropped{0};
+    inline static std::atomic<long long> handler_ns{0};
+    inline static long long period_ns = 0;
+    inline static bool active = false;
+    inline static std::atomic<bool> enabled{false};
+    inline static thread_local bool registered = false;
+    inline static thread_local uintptr_t stack_high = 0; // top of the calling thread's stack
+#endif
+};
+
+// Registers the enclosing thread with the sampling profiler for the object's lifetime, once
+// SamplingProfiler::enable() has been called; otherwise it does nothing.
+struct ProfiledThread {
+    ProfiledThread() { SamplingProfiler::register_thread(); }
+    ~ProfiledThread() { SamplingProfiler::unregister_thread(); }
+    ProfiledThread(const ProfiledThread&) = delete;
+    ProfiledThread& operator=(const ProfiledThread&) = delete;
+};
+
+// ------------------ Simple Thread Pool Implementation ---------------------
+// How idle workers wait for new tasks.
+enum class WaitStrategy {
+    Block,   // sleep on the condition variable (default)
+    Spin,    // busy-poll with a pause instruction, never sleep
+    Yield,   // poll, yielding the CPU between checks
+    Backoff  // exponential pause spinning, then yielding, then sleep on the condition variable
+};
+
+// Hints to the CPU that we are in a spin-wait loop.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Shared-queue priority lanes, served from High to Low.
+enum class Priority { High, Normal, Low };
+
+class ThreadPool {
+public:
+    ThreadPool(size_t num_threads, WaitStrategy wait_strategy = WaitStrategy::Block)
+        : local_tasks(num_threads), active(num_threads), stop(false), pinned(false),
+          wait_strategy(wait_strategy), changes(0)
+    {
+        for(size_t i = 0; i < num_threads; ++i) {
+            workers.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+    
+    template<class F, class... Args>
+    auto submit(F&& f, Args&&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+      return enqueue(Priority::Normal, shared_lane, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // Like submit(), but in the given priority lane. Idle workers always take the highest-priority
+    // task first, so splitting a long scan into low-priority chunks lets urgent work in between chunks.
+    template<class F, class... Args>
+    auto submit_with_priority(Priority priority, F&& f, Args&&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+      return enqueue(priority, shared_lane, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // Like submit(), but the task only runs on the given worker, so the data it touches
+    // stays in that worker's caches across repeated submissions. A worker index that is out of
+    // range, or retired by a concurrent resize(), falls back to the shared queue.
+    template<class F, class... Args>
+    auto submit_to(size_t worker, F&& f, Args&&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+      return enqueue(Priority::Normal, worker, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // Like submit(), but the task is skipped if the token has fired by the time a worker picks it up;
+    // its future then throws OperationCancelled. The token must outlive the task.
+    template<class F, class... Args>
+    auto submit_cancellable(const CancellationToken& token, F&& f, Args&&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+      auto bound = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+      return enqueue(Priority::Normal, shared_lane, [&token, bound]() mutable {
+          if (token.is_cancelled()) throw OperationCancelled();
+          return bound();
+      });
+    }
+
+    // Pins worker i to the i-th available core (wrapping around); workers added by resize() are pinned too.
+    // Returns false if any pin failed.
+    bool pin_workers()
+    {
+        pinned = true;
+        bool ok = true;
+        for (size_t i = 0; i < workers.size(); ++i)
+            ok = pin_worker(i) && ok;
+        return ok;
+    }
+
+    // Grows or shrinks the worker set without draining queued work. Retiring workers finish their
+    // current task and hand their routed tasks over to the shared queue; tasks routed to them later
+    // go to the shared queue as well. Safe to call while other threads submit, but not concurrently with itself.
+    void resize(size_t num_threads)
+    {
+        if (num_threads == 0)
+            throw std::invalid_argument("ThreadPool needs at least one worker");
+        const size_t old_size = workers.size();
+        if (num_threads > old_size) {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                local_tasks.resize(num_threads);
+                active = num_threads;
+                changes.fetch_add(1, std::memory_order_release);
+            }
+            for (size_t i = old_size; i < num_threads; ++i) {
+                workers.emplace_back(&ThreadPool::worker_loop, this, i);
+                if (pinned) pin_worker(i);
+            }
+        } else if (num_threads < old_size) {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                for (size_t i = num_threads; i < old_size; ++i) {
+                    for (; !local_tasks[i].empty(); local_tasks[i].pop())
+                        lane(Priority::Normal).push(std::move(local_tasks[i].front()));
+                }
+                active = num_threads;
+                changes.fetch_add(1, std::memory_order_release);
+            }
+            condition.notify_all();
+            for (size_t i = num_threads; i < old_size; ++i)
+                workers[i].join();
+            workers.resize(num_threads);
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            local_tasks.resize(num_threads);
+        }
+    }
+
+    // Workers that currently take tasks
+    size_t size() const
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        return active;
+    }
+    
+    ~ThreadPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+            changes.fetch_add(1, std::memory_order_release);
+        }
+        condition.notify_all();
+        for(std::thread &worker: workers)
+            worker.join();
+    }
+    
+private:
+    void worker_loop(size_t i)
+    {
+        ProfiledThread profiled_thread; // lets --profile sample this worker; a no-op without it
+        for(;;) {
+            std::function<void()> task;
+            
+            {   // acquire lock
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                auto ready = [this, i]() { return stop || i >= active || has_shared_tasks() || !local_tasks[i].empty(); };
+                if (!ready() && wait_strategy != WaitStrategy::Block) {
+                    // Poll without the lock until the pool state changes, then look again
+                    const unsigned long long seen = changes.load(std::memory_order_relaxed);
+                    lock.unlock();
+                    if (poll_for_change(seen)) continue;
+                    lock.lock();
+                }
+                condition.wait(lock, ready);
+                if (i >= active) return; // retired by resize()
+                if (stop && !has_shared_tasks() && local_tasks[i].empty()) return;
+                // Tasks routed to this worker take precedence over the shared lanes, which are served high to low
+                auto& queue = !local_tasks[i].empty() ? local_tasks[i] : next_shared_lane();
+                task = std::move(queue.front());
+                queue.pop();
+            }
+            
+            // execute task
+            task();
+        }
+    }
+
+    // Waits according to the wait strategy until the change counter moves past seen. Returns false
+    // when a backoff wait has run out of patience and the caller should block on the condition variable.
+    bool poll_for_change(unsigned long long seen)
+    {
+        auto changed = [this, seen]() { return changes.load(std::memory_order_acquire) != seen; };
+        if (wait_strategy == WaitStrategy::Spin) {
+            while (!changed()) cpuRelax();
+            return true;
+        }
+        if (wait_strategy == WaitStrategy::Yield) {
+            while (!changed()) std::this_thread::yield();
+            return true;
+        }
+        // Backoff: pause spins doubling up to 1024 per round, then a bounded number of yields
+        for (int spins = 1; spins <= 1024; spins *= 2) {
+            for (int k = 0; k < spins; ++k) cpuRelax();
+            if (changed()) return true;
+        }
+        for (int k = 0; k < 64; ++k) {
+            std::this_thread::yield();
+            if (changed()) return true;
+        }
+        return false;
+    }
+
+    using task_queue = std::queue<std::function<void()>>;
+
+    task_queue& lane(Priority priority) { return lanes[static_cast<size_t>(priority)]; }
+
+    // Both require queue_mutex to be held
+    bool has_shared_tasks() const
+    {
+        return std::any_of(lanes.begin(), lanes.end(), [](const task_queue& q) { return !q.empty(); });
+    }
+
+    task_queue& next_shared_lane()
+    {
+        for (task_queue& q : lanes)
+            if (!q.empty()) return q;
+        return lane(Priority::Normal);
+    }
+
+    bool pin_worker(size_t i)
+    {
+        const std::vector<int> cores = availableCores();
+        return pinThreadToCore(workers[i], cores[i % cores.size()]);
+    }
+
+    static constexpr size_t shared_lane = static_cast<size_t>(-1);
+
+    // Queues the task for the given worker, or in the priority's shared lane if the worker is
+    // shared_lane or not active; the queue is picked under the lock so resize() can't move it.
+    template<class F, class... Args>
+    auto enqueue(Priority priority, size_t worker, F&& f, Args&&... args)
+      -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+      using return_type = typename std::result_of<F(Args...)>::type;
+      
+      auto task = std::make_shared< std::packaged_task<return_type()> >(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+        );
+      
+      std::future<return_type> res = task->get_future();
+      bool shared;
+      {
+          std::unique_lock<std::mutex> lock(queue_mutex);
+          shared = worker >= active;
+          task_queue& queue = shared ? lane(priority) : local_tasks[worker];
+          queue.emplace([task](){ (*task)(); });
+          changes.fetch_add(1, std::memory_order_release);
+      }
+      // A routed task must wake its own worker, which notify_one cannot target
+      if (shared) condition.notify_one();
+      else        condition.notify_all();
+      return res;
+    }
+
+    std::vector<std::thread> workers;
+    std::array<task_queue, 3> lanes; // shared queues indexed by Priority
+    std::vector<task_queue> local_tasks;
+    
+    mutable std::mutex queue_mutex;
+    std::condition_variable condition;
+    size_t active; // workers with an index at or above this have been retired
+    bool stop;
+    bool pinned;
+    WaitStrategy wait_strategy;
+    std::atomic<unsigned long long> changes; // bumped on every enqueue, resize and stop; polled by spinning workers
+};
+// ------------------ End Thread Pool ---------------------------------------
+
+// Summation functions
+//
+// Each method also has a checked variant (--checked) that keeps the method's own loop but sums blocks
+// [first_block, last_block) of `block` (<= 2^b) elements into exact block_sums. Alongside its wrapping
+// 32-bit sum, the loop ORs every x + 2^(30 - b) into `range`; once per block, that OR staying below
+// 2^(31 - b) proves every element lies in [-2^(30 - b), 2^(30 - b)), so the block sum cannot have
+// left int range. checkedBlock redoes blocks without that headroom with 64-bit accumulation, and
+// runMethod finds overflow of an int running total from the block sums afterwards.
+
+// Exact sum of block b, from `loop(start, end, bias, sum, range)` where the headroom check allows.
+template<class Loop>
+long long checkedBlock(const std::vector<int>& arr, int b, int block, Loop&& loop) {
+    int block_bits = 0;
+    while ((1LL << block_bits) < block) ++block_bits;
+    const int start = b * block, end = std::min(static_cast<int>(arr.size()), start + block);
+    if (block_bits <= 30) {
+        uint32_t sum = 0, range = 0;
+        loop(start, end, 1u << (30 - block_bits), sum, range);
+        if ((range >> (31 - block_bits)) == 0) return static_cast<int32_t>(sum);
+    }
+    long long wide = 0;
+    for (int i = start; i < end; ++i) wide += arr[i];
+    return wide;
+}
+
+// The scalar loop shared by locked_sum, unlocked_sum and reduce_sum, with the headroom check.
+inline void checkedScalarLoop(const int* data, int start, int end, uint32_t bias, uint32_t& sum, uint32_t& range) {
+    for (int i = start; i < end; ++i) {
+        sum += static_cast<uint32_t>(data[i]);
+        range |= static_cast<uint32_t>(data[i]) + bias;
+    }
+}
+
+// Exact sum of blocks [first_block, last_block) with the scalar loop, written to block_sums.
+inline long long checkedScalarBlocks(const std::vector<int>& arr, int first_block, int last_block, int block,
+                                     std::vector<long long>& block_sums) {
+    long long total = 0;
+    for (int b = first_block; b < last_block; ++b) {
+        block_sums[b] = checkedBlock(arr, b, block, [&](int start, int end, uint32_t bias, uint32_t& sum, uint32_t& range) {
+            checkedScalarLoop(arr.data(), start, end, bias, sum, range);
+        });
+        total += block_sums[b];
+    }
+    return total;
+}
+
+// 1. Locked sum: each thread uses an atomic variable for safe addition.
+void locked_sum(const std::vector<int>& arr, int start, int end, std::atomic<int>& total) {
+    int sum = 0;
+    for (int i = start; i < end; ++i) {
+        sum += arr[i];
+    }
+    total += sum; // atomic addition is thread-safe
+}
+
+void locked_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block,
+                        std::vector<long long>& block_sums, std::atomic<long long>& total) {
+    total += checkedScalarBlocks(arr, first_block, last_block, block, block_sums);
+}
+
+// 2. Unlocked sum: intentionally unsafe (data race) to illustrate issues.
+void unlocked_sum(const std::vector<int>& arr, int start, int end, int& total) {
+    int sum = 0;
+    for (int i = start; i < end; ++i) {
+        sum += arr[i];
+    }
+    total += sum; // unsafe addition, no synchronization
+}
+
+void unlocked_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block,
+                          std::vector<long long>& block_sums, long long& total) {
+    total += checkedScalarBlocks(arr, first_block, last_block, block, block_sums); // still unsynchronized
+}
+
+// 3. Reduce-like operation: each thread computes a partial sum.
+void reduce_sum(const std::vector<int>& arr, int start, int end, int& partial_sum) {
+    int sum = 0;
+    for (int i = start; i < end; ++i) {
+        sum += arr[i];
+    }
+    partial_sum = sum;
+}
+
+void reduce_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block,
+                        std::vector<long long>& block_sums, long long& partial_sum) {
+    partial_sum = checkedScalarBlocks(arr, first_block, last_block, block, block_sums);
+}
+
+// 4. Parallel algorithm mode: uses C++17 parallel reduction.
+int parallel_sum(const std::vector<int>& arr) {
+#ifdef __cpp_lib_execution
+    return std::reduce(std::execution::par, arr.begin(), arr.end(), 0);
+#else
+    // If not available, fall back to sequential accumulate.
+    return std::accumulate(arr.begin(), arr.end(), 0);
+#endif
+}
+
+// The parallel algorithm over the blocks, each summed with the headroom check.
+void parallel_sum_checked(const std::vector<int>& arr, int block, std::vector<long long>& block_sums) {
+    const int n_blocks = static_cast<int>(block_sums.size());
+#ifdef __cpp_lib_execution
+    std::vector<int> blocks(n_blocks);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(),
+                  [&](int b) { checkedScalarBlocks(arr, b, b + 1, block, block_sums); });
+#else
+    checkedScalarBlocks(arr, 0, n_blocks, block, block_sums);
+#endif
+}
+
+// 5. Unrolled sum: reduce-like, but each thread runs the multi-accumulator kernel below.
+template<int Unroll, int Accumulators, class T>
+T unrolled_kernel(const T* data, size_t n);
+
+void unrolled_sum(const std::vector<int>& arr, int start, int end, int& partial_sum) {
+    partial_sum = unrolled_kernel<8, 8>(arr.data() + start, static_cast<size_t>(end - start));
+}
+
+// unrolled_kernel<8, 8>'s loop, with a headroom OR next to each of the eight accumulators.
+void unrolled_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block,
+                          std::vector<long long>& block_sums, long long& partial_sum) {
+    constexpr int Unroll = 8, Accumulators = 8;
+    partial_sum = 0;
+    for (int b = first_block; b < last_block; ++b) {
+        block_sums[b] = checkedBlock(arr, b, block, [&](int start, int end, uint32_t bias, uint32_t& sum, uint32_t& range) {
+            const int* data = arr.data();
+            uint32_t acc[Accumulators] = {}, rng[Accumulators] = {};
+            int i = start;
+            for (; i + Unroll <= end; i += Unroll) {
+                for (int u = 0; u < Unroll; ++u) {
+                    acc[u % Accumulators] += static_cast<uint32_t>(data[i + u]);
+                    rng[u % Accumulators] |= static_cast<uint32_t>(data[i + u]) + bias;
+                }
+            }
+            for (; i < end; ++i) {
+                acc[0] += static_cast<uint32_t>(data[i]);
+                rng[0] |= static_cast<uint32_t>(data[i]) + bias;
+            }
+            for (int a = 0; a < Accumulators; ++a) {
+                sum += acc[a];
+                range |= rng[a];
+            }
+        });
+        partial_sum += block_sums[b];
+    }
+}
+
+// Issues a software prefetch for reading; non-temporal hints ask the CPU to keep the line out of outer caches.
+inline void prefetchRead(const void* p, bool non_temporal) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (non_temporal) __builtin_prefetch(p, 0, 0);
+    else              __builtin_prefetch(p, 0, 3);
+#elif defined(_M_X64) || defined(_M_IX86)
+    _mm_prefetch(static_cast<const char*>(p), non_temporal ? _MM_HINT_NTA : _MM_HINT_T0);
+#else
+    (void)p; (void)non_temporal;
+#endif
+}
+
+// 6. Prefetch sum: reduce-like, prefetching one cache line distance_bytes ahead of the loads.
+void prefetch_sum(const std::vector<int>& arr, int start, int end, int& partial_sum, int distance_bytes, bool non_temporal) {
+    constexpr int line = 64 / sizeof(int);
+    const int* data = arr.data();
+    const int ahead = distance_bytes / static_cast<int>(sizeof(int));
+    int sum = 0;
+    int i = start;
+    for (; i + line <= end; i += line) {
+        if (ahead > 0 && end - i > ahead) {
+            prefetchRead(data + i + ahead, non_temporal);
+        }
+        for (int j = 0; j < line; ++j) {
+            sum += data[i + j];
+        }
+    }
+    for (; i < end; ++i) {
+        sum += data[i];
+    }
+    partial_sum = sum;
+}
+
+void prefetch_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block, std::vector<long long>& block_sums,
+                          long long& partial_sum, int distance_bytes, bool non_temporal) {
+    constexpr int line = 64 / sizeof(int);
+    const int* data = arr.data();
+    const int ahead = distance_bytes / static_cast<int>(sizeof(int));
+    const int array_end = static_cast<int>(arr.size());
+    partial_sum = 0;
+    for (int b = first_block; b < last_block; ++b) {
+        block_sums[b] = checkedBlock(arr, b, block, [&](int start, int end, uint32_t bias, uint32_t& sum, uint32_t& range) {
+            int i = start;
+            for (; i + line <= end; i += line) {
+                if (ahead > 0 && array_end - i > ahead) {
+                    prefetchRead(data + i + ahead, non_temporal);
+                }
+                for (int j = 0; j < line; ++j) {
+                    sum += static_cast<uint32_t>(data[i + j]);
+                    range |= static_cast<uint32_t>(data[i + j]) + bias;
+                }
+            }
+            checkedScalarLoop(data, i, end, bias, sum, range);
+        });
+        partial_sum += block_sums[b];
+    }
+}
+
+// 7. Stream sum: reduce-like, using non-temporal (movntdqa) vector loads where the target supports them.
+// Without SSE4.1 this falls back to non-temporal software prefetch.
+void stream_sum(const std::vector<int>& arr, int start, int end, int& partial_sum, int distance_bytes) {
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#if defined(__AVX2__)
+    using vec = __m256i;
+    auto stream_load = [](const int* p) { return _mm256_stream_load_si256(reinterpret_cast<vec*>(const_cast<int*>(p))); };
+    auto add = [](vec a, vec b) { return _mm256_add_epi32(a, b); };
+    auto zero = []() { return _mm256_setzero_si256(); };
+#else
+    using vec = __m128i;
+    auto stream_load = [](const int* p) { return _mm_stream_load_si128(reinterpret_cast<vec*>(const_cast<int*>(p))); };
+    auto add = [](vec a, vec b) { return _mm_add_epi32(a, b); };
+    auto zero = []() { return _mm_setzero_si128(); };
+#endif
+    constexpr int lanes = sizeof(vec) / sizeof(int);
+    (void)distance_bytes;
+    const int* data = arr.data();
+    int sum = 0;
+    int i = start;
+    // Scalar head up to the first vector-aligned element
+    while (i < end && reinterpret_cast<uintptr_t>(data + i) % sizeof(vec) != 0) {
+        sum += data[i++];
+    }
+    vec acc0 = zero(), acc1 = zero();
+    for (; i + 2 * lanes <= end; i += 2 * lanes) {
+        acc0 = add(acc0, stream_load(data + i));
+        acc1 = add(acc1, stream_load(data + i + lanes));
+    }
+    alignas(sizeof(vec)) int lane_sums[lanes];
+    std::memcpy(lane_sums, &acc0, sizeof(vec));
+    for (int l = 0; l < lanes; ++l) sum += lane_sums[l];
+    std::memcpy(lane_sums, &acc1, sizeof(vec));
+    for (int l = 0; l < lanes; ++l) sum += lane_sums[l];
+    for (; i < end; ++i) {
+        sum += data[i];
+    }
+    partial_sum = sum;
+#else
+    prefetch_sum(arr, start, end, partial_sum, distance_bytes, true);
+#endif
+}
+
+void stream_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block,
+                        std::vector<long long>& block_sums, long long& partial_sum, int distance_bytes) {
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#if defined(__AVX2__)
+    using vec = __m256i;
+    auto stream_load = [](const int* p) { return _mm256_stream_load_si256(reinterpret_cast<vec*>(const_cast<int*>(p))); };
+    auto add = [](vec a, vec b) { return _mm256_add_epi32(a, b); };
+    auto bitwise_or = [](vec a, vec b) { return _mm256_or_si256(a, b); };
+    auto broadcast = [](uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); };
+#else
+    using vec = __m128i;
+    auto stream_load = [](const int* p) { return _mm_stream_load_si128(reinterpret_cast<vec*>(const_cast<int*>(p))); };
+    auto add = [](vec a, vec b) { return _mm_add_epi32(a, b); };
+    auto bitwise_or = [](vec a, vec b) { return _mm_or_si128(a, b); };
+    auto broadcast = [](uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); };
+#endif
+    constexpr int lanes = sizeof(vec) / sizeof(int);
+    (void)distance_bytes;
+    const int* data = arr.data();
+    partial_sum = 0;
+    for (int b = first_block; b < last_block; ++b) {
+        block_sums[b] = checkedBlock(arr, b, block, [&](int start, int end, uint32_t bias, uint32_t& sum, uint32_t& range) {
+            int i = start;
+            while (i < end && reinterpret_cast<uintptr_t>(data + i) % sizeof(vec) != 0) {
+                checkedScalarLoop(data, i, i + 1, bias, sum, range);
+                ++i;
+            }
+            const vec bias_v = broadcast(bias);
+            vec acc0 = broadcast(0), acc1 = broadcast(0), rng0 = broadcast(0), rng1 = broadcast(0);
+            for (; i + 2 * lanes <= end; i += 2 * lanes) {
+                const vec x0 = stream_load(data + i), x1 = stream_load(data + i + lanes);
+                acc0 = add(acc0, x0);
+                acc1 = add(acc1, x1);
+                rng0 = bitwise_or(rng0, add(x0, bias_v));
+                rng1 = bitwise_or(rng1, add(x1, bias_v));
+            }
+            const vec acc = add(acc0, acc1), rng = bitwise_or(rng0, rng1);
+            alignas(sizeof(vec)) uint32_t lane_values[lanes];
+            std::memcpy(lane_values, &acc, sizeof(vec));
+            for (int l = 0; l < lanes; ++l) sum += lane_values[l];
+            std::memcpy(lane_values, &rng, sizeof(vec));
+            for (int l = 0; l < lanes; ++l) range |= lane_values[l];
+            checkedScalarLoop(data, i, end, bias, sum, range);
+        });
+        partial_sum += block_sums[b];
+    }
+#else
+    prefetch_sum_checked(arr, first_block, last_block, block, block_sums, partial_sum, distance_bytes, true);
+#endif
+}
+
+// 8. Cancellable sum: reduce-like, checking the token every `chunk` elements so a cancelled
+// scan stops promptly. `processed` receives how many elements were summed.
+void cancellable_sum(const std::vector<int>& arr, int start, int end, int& partial_sum, int& processed,
+                     const CancellationToken& token, int chunk) {
+    int sum = 0;
+    int i = start;
+    while (i < end && !token.is_cancelled()) {
+        const int stop = std::min(end, i + chunk);
+        for (; i < stop; ++i) {
+            sum += arr[i];
+        }
+    }
+    partial_sum = sum;
+    processed = i - start;
+}
+
+// Checked variant: the token is still checked every `chunk` elements. A block the token interrupts is
+// dropped, so block_sums and `processed` cover whole blocks only.
+void cancellable_sum_checked(const std::vector<int>& arr, int first_block, int last_block, int block, std::vector<long long>& block_sums,
+                             long long& partial_sum, int& processed, const CancellationToken& token, int chunk) {
+    partial_sum = 0;
+    processed = 0;
+    for (int b = first_block; b < last_block && !token.is_cancelled(); ++b) {
+        bool interrupted = false;
+        const long long block_sum = checkedBlock(arr, b, block, [&](int start, int end, uint32_t bias, uint32_t& sum, uint32_t& range) {
+            int i = start;
+            while (i < end && !token.is_cancelled()) {
+                const int stop = std::min(end, i + chunk);
+                checkedScalarLoop(arr.data(), i, stop, bias, sum, range);
+                i = stop;
+            }
+            interrupted = i < end;
+        });
+        if (interrupted) break;
+        block_sums[b] = block_sum;
+        partial_sum += block_sum;
+        processed += std::min(static_cast<int>(arr.size()), (b + 1) * block) - b * block;
+    }
+}
+
+// Population count of one 64-bit word, using the popcnt instruction where the target has it.
+inline int popcount64(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(w);
+#elif defined(_M_X64)
+    return static_cast<int>(__popcnt64(w));
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ull);
+    w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((w * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// 9. Popcount sum: counts the set bits of words [start, end) of a bitmap, one popcnt per word.
+void popcount_sum(const std::vector<uint64_t>& words, int start, int end, int& partial_sum) {
+    int count = 0;
+    for (int i = start; i < end; ++i) {
+        count += popcount64(words[i]);
+    }
+    partial_sum = count;
+}
+
+#if defined(__AVX2__)
+// Per-64-bit-lane popcount of a 256-bit vector: nibble lookup with vpshufb, then horizontal byte sums.
+inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+// Carry-save adder: (high, low) = a + b + c bitwise.
+inline void carrySaveAdd(__m256i& high, __m256i& low, __m256i a, __m256i b, __m256i c) {
+    const __m256i u = _mm256_xor_si256(a, b);
+    high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    low = _mm256_xor_si256(u, c);
+}
+#endif
+
+// 10. Harley-Seal popcount sum: a carry-save adder tree over 16 AVX2 vectors per iteration, so only one
+// vector popcount is needed per 4096 bits. Without AVX2 this falls back to popcount_sum.
+void harley_seal_sum(const std::vector<uint64_t>& words, int start, int end, int& partial_sum) {
+#if defined(__AVX2__)
+    constexpr int lanes = sizeof(__m256i) / sizeof(uint64_t);
+    const uint64_t* data = words.data();
+    auto load = [&](int i) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)); };
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256(), twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256(), eights = _mm256_setzero_si256();
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b, sixteens;
+    int i = start;
+    for (; i + 16 * lanes <= end; i += 16 * lanes) {
+        carrySaveAdd(twos_a, ones, ones, load(i), load(i + lanes));
+        carrySaveAdd(twos_b, ones, ones, load(i + 2 * lanes), load(i + 3 * lanes));
+        carrySaveAdd(fours_a, twos, twos, twos_a, twos_b);
+        carrySaveAdd(twos_a, ones, ones, load(i + 4 * lanes), load(i + 5 * lanes));
+        carrySaveAdd(twos_b, ones, ones, load(i + 6 * lanes), load(i + 7 * lanes));
+        carrySaveAdd(fours_b, twos, twos, twos_a, twos_b);
+        carrySaveAdd(eights_a, fours, fours, fours_a, fours_b);
+        carrySaveAdd(twos_a, ones, ones, load(i + 8 * lanes), load(i + 9 * lanes));
+        carrySaveAdd(twos_b, ones, ones, load(i + 10 * lanes), load(i + 11 * lanes));
+        carrySaveAdd(fours_a, twos, twos, twos_a, twos_b);
+        carrySaveAdd(twos_a, ones, ones, load(i + 12 * lanes), load(i + 13 * lanes));
+        carrySaveAdd(twos_b, ones, ones, load(i + 14 * lanes), load(i + 15 * lanes));
+        carrySaveAdd(fours_b, twos, twos, twos_a, twos_b);
+        carrySaveAdd(eights_b, fours, fours, fours_a, fours_b);
+        carrySaveAdd(sixteens, eights, eights, eights_a, eights_b);
+        total = _mm256_add_epi64(total, popcount256(sixteens));
+    }
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(twos), 1));
+    total = _mm256_add_epi64(total, popcount256(ones));
+    for (; i + lanes <= end; i += lanes) {
+        total = _mm256_add_epi64(total, popcount256(load(i)));
+    }
+    alignas(sizeof(__m256i)) uint64_t lane_counts[lanes];
+    std::memcpy(lane_counts, &total, sizeof(total));
+    int count = 0;
+    for (int l = 0; l < lanes; ++l) count += static_cast<int>(lane_counts[l]);
+    for (; i < end; ++i) {
+        count += popcount64(data[i]);
+    }
+    partial_sum = count;
+#else
+    popcount_sum(words, start, end, partial_sum);
+#endif
+}
+
+// ------------------ Multi-Accumulator Kernels ------------------------------
+// Processes Unroll elements per iteration, spreading them over Accumulators
+// independent partial sums so that consecutive adds do not wait on each other.
+template<int Unroll, int Accumulators, class T>
+T unrolled_kernel(const T* data, size_t n) {
+    static_assert(Unroll % Accumulators == 0, "Unroll must be a multiple of Accumulators");
+    T acc[Accumulators] = {};
+    size_t i = 0;
+    for (; i + Unroll <= n; i += Unroll) {
+        for (int u = 0; u < Unroll; ++u) {
+            acc[u % Accumulators] += data[i + u];
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] += data[i];
+    }
+    T sum = 0;
+    for (int a = 0; a < Accumulators; ++a) {
+        sum += acc[a];
+    }
+    return sum;
+}
+
+// Keeps the compiler from hoisting repeated kernel calls over unchanged data.
+inline void clobberMemory() {
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+struct SweepResult {
+    int unroll;
+    int accumulators;
+    double gbps;
+};
+
+// Times one kernel instantiation over data that stays resident in the cache level being tested.
+template<class T, int Unroll, int Accumulators>
+void sweepCell(const std::vector<T>& data, std::vector<SweepResult>& results) {
+    if constexpr (Accumulators <= Unroll && Unroll % Accumulators == 0) {
+        const size_t target_elements = 64u << 20; // ~64M elements per sample
+        const size_t reps = std::max<size_t>(1, target_elements / data.size());
+        double best_ns = 1e300;
+        volatile T sink = 0;
+        for (int sample = 0; sample < 5; ++sample) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            for (size_t r = 0; r < reps; ++r) {
+                clobberMemory();
+                sink = unrolled_kernel<Unroll, Accumulators>(data.data(), data.size());
+            }
+            auto end_time = std::chrono::high_resolution_clock::now();
+            best_ns = std::min(best_ns, std::chrono::duration<double, std::nano>(end_time - start_time).count());
+        }
+        (void)sink;
+        double bytes = static_cast<double>(reps) * data.size() * sizeof(T);
+        results.push_back({Unroll, Accumulators, bytes / best_ns});
+    }
+}
+
+template<class T, int Unroll>
+void sweepRow(const std::vector<T>& data, std::vector<SweepResult>& results) {
+    sweepCell<T, Unroll, 1>(data, results);
+    sweepCell<T, Unroll, 2>(data, results);
+    sweepCell<T, Unroll, 4>(data, results);
+    sweepCell<T, Unroll, 8>(data, results);
+}
+
+template<class T>
+std::vector<SweepResult> sweepGrid(const std::vector<T>& data) {
+    std::vector<SweepResult> results;
+    sweepRow<T, 1>(data, results);
+    sweepRow<T, 2>(data, results);
+    sweepRow<T, 4>(data, results);
+    sweepRow<T, 8>(data, results);
+    sweepRow<T, 16>(data, results);
+    return results;
+}
+
+// Returns the size in bytes of the given data cache level, or the fallback if it cannot be queried.
+size_t cacheSize(int level, size_t fallback) {
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    long size = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE);
+    if (size > 0) return static_cast<size_t>(size);
+#else
+    (void)level;
+#endif
+    return fallback;
+}
+
+template<class T>
+void sweepType(const std::string& type_name, std::ofstream& csv_file) {
+    const std::pair<std::string, size_t> levels[] = {
+        {"L1", cacheSize(1, 32 * 1024) / 2},
+        {"L2", cacheSize(2, 1024 * 1024) / 2},
+    };
+    for (const auto& [level, bytes] : levels) {
+        std::vector<T> data(bytes / sizeof(T));
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<T>(rand() % 100);
+        }
+        std::vector<SweepResult> results = sweepGrid(data);
+        auto best = std::max_element(results.begin(), results.end(),
+                                     [](const SweepResult& a, const SweepResult& b) { return a.gbps < b.gbps; });
+
+        std::cout << "\n--- " << type_name << ", " << level << "-resident (" << bytes / 1024 << " KiB) ---" << std::endl;
+        std::cout << "Unroll  Accumulators  GB/s" << std::endl;
+        for (const SweepResult& r : results) {
+            std::cout << std::setw(6) << r.unroll << std::setw(14) << r.accumulators
+                      << std::setw(8) << std::fixed << std::setprecision(2) << r.gbps
+                      << (&r == &*best ? "  <- best" : "") << std::endl;
+            csv_file << type_name << "," << level << "," << bytes << "," << r.unroll << ","
+                     << r.accumulators << "," << r.gbps << "\n";
+        }
+        std::cout.unsetf(std::ios::floatfield);
+    }
+}
+
+// Benchmark mode: instantiates the unroll x accumulator grid and reports the winner per type and cache level.
+int runUnrollSweep() {
+    std::ofstream csv_file("unroll_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open unroll_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Type,Level,Bytes,Unroll,Accumulators,GBps\n";
+    sweepType<int>("int", csv_file);
+    sweepType<float>("float", csv_file);
+    sweepType<double>("double", csv_file);
+    std::cout << "\nResults written to unroll_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Multi-Accumulator Kernels --------------------------
+
+// Parses a comma-separated list of positive integers (distances, bin counts, ...).
+// Malformed and non-positive entries are reported as "Invalid <what>: <token>" and skipped.
+std::vector<int> parseIntList(const std::string& s, const std::string& what = "value in list") {
+    std::vector<int> values;
+    std::stringstream ss(s);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        try {
+            int value = std::stoi(token);
+            if (value <= 0) throw std::out_of_range(token);
+            values.push_back(value);
+        } catch (...) {
+            std::cerr << "Invalid " << what << ": " << token << std::endl;
+        }
+    }
+    return values;
+}
+
+// Utility to split a comma-separated list of thread counts into integers.
+std::vector<int> parseThreadCounts(const std::string& s) {
+    return parseIntList(s, "thread count value");
+}
+
+// Bounds [first, second) of block t when [0, size) is split into n_blocks contiguous blocks
+// whose sizes differ by at most one, so no block is empty unless size < n_blocks.
+inline std::pair<int, int> blockRange(int t, int n_blocks, int size) {
+    auto bound = [&](int k) { return static_cast<int>(static_cast<long long>(size) * k / n_blocks); };
+    return {bound(t), bound(t + 1)};
+}
+
+// Utility to fill the array based on distribution type.
+// "flags" fills 0/1 values, each set with probability density.
+void fillArray(std::vector<int>& arr, const std::string& dist, double density = 0.5) {
+    if (dist == "sorted") {
+        for (size_t i = 0; i < arr.size(); ++i) {
+            arr[i] = static_cast<int>(i);
+        }
+    }
+    else if (dist == "reverse") {
+        for (size_t i = 0; i < arr.size(); ++i) {
+            arr[i] = static_cast<int>(arr.size() - i);
+        }
+    }
+    else if (dist == "flags") {
+        for (auto& v : arr) {
+            v = (rand() < density * (static_cast<double>(RAND_MAX) + 1.0)) ? 1 : 0;
+        }
+    }
+    else { // default "rand"
+        std::generate(arr.begin(), arr.end(), []() { return rand() % 100; });
+    }
+}
+
+// Set flags packed one per bit, 64 to a word; the bits past `bits` in the last word are zero.
+struct Bitmap {
+    std::vector<uint64_t> words;
+    size_t bits = 0;
+};
+
+// Packs arr into a bitmap with bit i set when arr[i] is non-zero.
+Bitmap packFlags(const std::vector<int>& arr) {
+    Bitmap bitmap;
+    bitmap.bits = arr.size();
+    bitmap.words.assign((arr.size() + 63) / 64, 0);
+    for (size_t i = 0; i < arr.size(); ++i) {
+        if (arr[i] != 0) bitmap.words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    return bitmap;
+}
+
+// Nearest-rank percentile (p in [0, 100]) of a set of samples.
+double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+    return samples[std::min(samples.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+// Reduce-like parallel sum with the array split into chunk-sized tasks in the given priority lane,
+// so higher-priority work submitted meanwhile runs between chunks instead of behind whole blocks.
+// Chunks add into their worker's slot, so there is one partial per worker rather than per chunk.
+int chunkedReduce(const std::vector<int>& arr, ThreadPool& pool, int chunk, Priority priority) {
+    const int array_size = static_cast<int>(arr.size());
+    const int n_chunks = (array_size + chunk - 1) / chunk;
+    zen::combinable<int> partial_sums;
+    std::vector<std::future<void>> futures;
+    futures.reserve(n_chunks);
+    for (int c = 0; c < n_chunks; ++c) {
+        const int start_index = c * chunk;
+        futures.push_back(pool.submit_with_priority(priority, [&arr, &partial_sums, start_index, end_index = std::min(array_size, start_index + chunk)]() {
+            int partial = 0;
+            reduce_sum(arr, start_index, end_index, partial);
+            partial_sums.local() += partial;
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+    return partial_sums.combine(std::plus<>());
+}
+
+// Checked variant of chunkedReduce: each task sums a whole number of blocks (about `chunk` elements)
+// with the headroom check, into per-worker 64-bit partials. Returns the exact total.
+long long chunkedReduceChecked(const std::vector<int>& arr, ThreadPool& pool, int chunk, int block,
+                               std::vector<long long>& block_sums, Priority priority) {
+    const int n_blocks = static_cast<int>(block_sums.size());
+    const int blocks_per_chunk = std::max(1, chunk / block);
+    zen::combinable<long long> partial_sums;
+    std::vector<std::future<void>> futures;
+    futures.reserve((n_blocks + blocks_per_chunk - 1) / blocks_per_chunk);
+    for (int first_block = 0; first_block < n_blocks; first_block += blocks_per_chunk) {
+        futures.push_back(pool.submit_with_priority(priority, [&, first_block, last_block = std::min(n_blocks, first_block + blocks_per_chunk)]() {
+            long long partial = 0;
+            reduce_sum_checked(arr, first_block, last_block, block, block_sums, partial);
+            partial_sums.local() += partial;
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+    return partial_sums.combine(std::plus<>());
+}
+
+// Tunables shared by the summation methods.
+struct SumOptions {
+    int prefetch_distance = 1024;   // bytes ahead of the current load for software prefetch
+    std::string affinity = "fresh"; // fresh: new pool per run, shared: reused pool, sticky: reused pinned pool with block t on worker t
+    WaitStrategy wait_strategy = WaitStrategy::Block; // how idle pool workers wait
+    int cancel_chunk = 16384;       // elements between cancellation checks
+    int scan_chunk = 65536;         // elements per task for the chunked method
+    const Bitmap* bitmap = nullptr; // packed flags of the array for the popcount methods; packed per run if null
+    int check_block = 65536;        // elements per overflow-checked block for checked runs
+};
+
+// Outcome of a checked summation: the exact total and, if an int running total over the array in
+// order would leave int range, the first block where it does.
+struct CheckedSum {
+    long long total = 0;
+    long long first_overflow_block = -1;
+    bool overflowed() const { return first_overflow_block >= 0; }
+};
+
+// Parses "block", "spin", "yield" or "backoff". Throws std::invalid_argument on anything else.
+WaitStrategy parseWaitStrategy(const std::string& s) {
+    if (s == "block")   return WaitStrategy::Block;
+    if (s == "spin")    return WaitStrategy::Spin;
+    if (s == "yield")   return WaitStrategy::Yield;
+    if (s == "backoff") return WaitStrategy::Backoff;
+    throw std::invalid_argument("unknown wait strategy: " + s);
+}
+
+// Every method runMethod accepts. --method is checked against it, and --list-methods prints it for the
+// PGO training sweep and compare_builds.py, so a new method only has to be added here.
+const std::vector<std::string> kMethods = {"locked", "unlocked", "reduce", "unrolled", "prefetch", "prefetch-nta", "stream",
+                                           "cancellable", "chunked", "popcount", "popcount-hs", "parallel"};
+
+// Total and first int overflow of checked block sums. `total` is the method's own exact total.
+CheckedSum scanBlockSums(const std::vector<long long>& block_sums, long long total) {
+    CheckedSum result{total, -1};
+    long long running = 0;
+    for (size_t b = 0; b < block_sums.size() && result.first_overflow_block < 0; ++b) {
+        running += block_sums[b];
+        if (running > std::numeric_limits<int>::max() || running < std::numeric_limits<int>::min())
+            result.first_overflow_block = static_cast<long long>(b);
+    }
+    return result;
+}
+
+// Runs one summation of arr with the given method on n_threads pool workers and returns the total.
+// Without a pool a fresh one is created for the run; otherwise the given pool is reused.
+// With `checked`, the method's checked variant runs instead, with the blocks of opts.check_block
+// elements split across the workers: *checked receives the exact total and the first block where an
+// int running total overflows, and the return value is that total wrapped to int, as the unchecked
+// method would return it. The popcount methods count at most arr.size() elements, so they cannot
+// overflow and run unchanged.
+int runMethod(const std::string& method, const std::vector<int>& arr, int n_threads, const SumOptions& opts = {},
+              ThreadPool* shared_pool = nullptr, CheckedSum* checked = nullptr) {
+    if (checked && opts.check_block <= 0)
+        throw std::invalid_argument("check block must be positive");
+    const int n_blocks = checked ? static_cast<int>((arr.size() + opts.check_block - 1) / opts.check_block) : 0;
+    std::vector<long long> block_sums(n_blocks, 0);
+    auto finishChecked = [&](long long total) {
+        *checked = scanBlockSums(block_sums, total);
+        return static_cast<int>(static_cast<uint32_t>(total));
+    };
+    if (method == "parallel") {
+        // Note: thread count is not used in parallel mode.
+        if (checked) {
+            parallel_sum_checked(arr, opts.check_block, block_sums);
+            return finishChecked(std::accumulate(block_sums.begin(), block_sums.end(), 0LL));
+        }
+        return parallel_sum(arr);
+    }
+
+    if (n_threads <= 0)
+        throw std::invalid_argument("thread count must be positive");
+    int array_size = static_cast<int>(arr.size());
+    std::unique_ptr<ThreadPool> local_pool;
+    if (!shared_pool) local_pool = std::make_unique<ThreadPool>(n_threads, opts.wait_strategy);
+    ThreadPool& pool = shared_pool ? *shared_pool : *local_pool;
+    const bool sticky = (opts.affinity == "sticky");
+    std::vector<std::future<void>> futures;
+    // Sticky placement sends block t to worker t every run, so it is summed from the same core's caches.
+    auto dispatch = [&](int t, auto&&... task) {
+        return sticky ? pool.submit_to(t % pool.size(), task...) : pool.submit(task...);
+    };
+    auto forEachBlock = [&](auto&& submit_block) {
+        for (int t = 0; t < n_threads; ++t) {
+            auto [start_index, end_index] = blockRange(t, n_threads, array_size);
+            futures.push_back(submit_block(t, start_index, end_index));
+        }
+        for(auto &f: futures) { f.get(); }
+    };
+
+    if (checked && method != "popcount" && method != "popcount-hs") {
+        const int block = opts.check_block;
+        // Like forEachBlock, but each worker gets a contiguous range of whole check blocks
+        auto forEachBlockRange = [&](auto&& submit_range) {
+            for (int t = 0; t < n_threads; ++t) {
+                auto [first_block, last_block] = blockRange(t, n_threads, n_blocks);
+                futures.push_back(submit_range(t, first_block, last_block));
+            }
+            for (auto& f : futures) { f.get(); }
+        };
+        if (method == "locked") {
+            std::atomic<long long> total_atomic(0);
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, locked_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums), std::ref(total_atomic)); });
+            return finishChecked(total_atomic.load());
+        }
+        if (method == "unlocked") {
+            long long total_unlocked = 0;
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, unlocked_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums), std::ref(total_unlocked)); });
+            return finishChecked(total_unlocked);
+        }
+        if (method == "chunked")
+            return finishChecked(chunkedReduceChecked(arr, pool, opts.scan_chunk, block, block_sums, Priority::Normal));
+        std::vector<long long> partial_sums(n_threads, 0);
+        if (method == "reduce") {
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, reduce_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums), std::ref(partial_sums[t])); });
+        } else if (method == "unrolled") {
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, unrolled_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums), std::ref(partial_sums[t])); });
+        } else if (method == "cancellable") {
+            CancellationToken token;
+            std::vector<int> processed(n_threads, 0);
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, cancellable_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums),
+                                                                         std::ref(partial_sums[t]), std::ref(processed[t]), std::cref(token), opts.cancel_chunk); });
+        } else if (method == "prefetch" || method == "prefetch-nta") {
+            const bool nta = (method == "prefetch-nta");
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, prefetch_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums),
+                                                                         std::ref(partial_sums[t]), opts.prefetch_distance, nta); });
+        } else { // "stream"
+            forEachBlockRange([&](int t, int f, int l) { return dispatch(t, stream_sum_checked, std::cref(arr), f, l, block, std::ref(block_sums),
+                                                                         std::ref(partial_sums[t]), opts.prefetch_distance); });
+        }
+        return finishChecked(std::accumulate(partial_sums.begin(), partial_sums.end(), 0LL));
+    }
+
+    if (method == "locked") {
+        std::atomic<int> total_atomic(0);
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, locked_sum, std::ref(arr), s, e, std::ref(total_atomic)); });
+        return total_atomic.load();
+    }
+    if (method == "unlocked") {
+        int total_unlocked = 0;
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, unlocked_sum, std::ref(arr), s, e, std::ref(total_unlocked)); });
+        return total_unlocked;
+    }
+    std::vector<int> partial_sums(n_threads, 0);
+    if (method == "reduce") {
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, reduce_sum, std::ref(arr), s, e, std::ref(partial_sums[t])); });
+    } else if (method == "unrolled") {
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, unrolled_sum, std::ref(arr), s, e, std::ref(partial_sums[t])); });
+    } else if (method == "chunked") {
+        return chunkedReduce(arr, pool, opts.scan_chunk, Priority::Normal);
+    } else if (method == "cancellable") {
+        // Token cost only: the token never fires, but every chunk boundary checks it
+        CancellationToken token;
+        std::vector<int> processed(n_threads, 0);
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, cancellable_sum, std::ref(arr), s, e, std::ref(partial_sums[t]),
+                                                                std::ref(processed[t]), std::cref(token), opts.cancel_chunk); });
+    } else if (method == "popcount" || method == "popcount-hs") {
+        // Counts the non-zero elements from the packed bitmap, splitting its words across the blocks
+        Bitmap packed;
+        if (!opts.bitmap) packed = packFlags(arr);
+        const std::vector<uint64_t>& words = opts.bitmap ? opts.bitmap->words : packed.words;
+        const int n_words = static_cast<int>(words.size());
+        auto kernel = (method == "popcount") ? popcount_sum : harley_seal_sum;
+        for (int t = 0; t < n_threads; ++t) {
+            auto [start_index, end_index] = blockRange(t, n_threads, n_words);
+            futures.push_back(dispatch(t, kernel, std::cref(words), start_index, end_index, std::ref(partial_sums[t])));
+        }
+        for (auto& f : futures) { f.get(); }
+    } else if (method == "prefetch" || method == "prefetch-nta") {
+        const bool nta = (method == "prefetch-nta");
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, prefetch_sum, std::ref(arr), s, e, std::ref(partial_sums[t]), opts.prefetch_distance, nta); });
+    } else { // "stream"
+        forEachBlock([&](int t, int s, int e) { return dispatch(t, stream_sum, std::ref(arr), s, e, std::ref(partial_sums[t]), opts.prefetch_distance); });
+    }
+    const int total = std::accumulate(partial_sums.begin(), partial_sums.end(), 0);
+    if (checked) *checked = {total, -1}; // popcount: a count of at most arr.size() elements
+    return total;
+}
+
+// Creates the pool that repeated runs share, or null for the fresh-pool-per-run behaviour.
+std::unique_ptr<ThreadPool> makeRunPool(const SumOptions& opts, int n_threads) {
+    if (opts.affinity == "fresh") return nullptr;
+    auto pool = std::make_unique<ThreadPool>(n_threads, opts.wait_strategy);
+    if (opts.affinity == "sticky" && !pool->pin_workers())
+        std::cerr << "Warning: could not pin pool workers; sticky placement will not be core-affine" << std::endl;
+    return pool;
+}
+
+// Outcome of a cancellable parallel reduction.
+struct ReduceResult {
+    enum class Status { Complete, Cancelled, DeadlineExceeded };
+    Status status = Status::Complete;
+    int sum = 0;            // partial if the reduction did not complete
+    long long processed = 0; // elements that contributed to sum
+};
+
+// Reduce-like parallel sum that honours a cancellation token and deadline at chunk boundaries.
+// Blocks that have not started when the token fires are skipped entirely.
+ReduceResult cancellableReduce(const std::vector<int>& arr, ThreadPool& pool, int n_threads,
+                               const CancellationToken& token, int chunk) {
+    const int array_size = static_cast<int>(arr.size());
+    std::vector<int> partial_sums(n_threads, 0), processed(n_threads, 0);
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < n_threads; ++t) {
+        auto [start_index, end_index] = blockRange(t, n_threads, array_size);
+        futures.push_back(pool.submit_cancellable(token, cancellable_sum, std::ref(arr), start_index, end_index,
+                                                  std::ref(partial_sums[t]), std::ref(processed[t]), std::cref(token), chunk));
+    }
+    for (auto& f : futures) {
+        try { f.get(); } catch (const OperationCancelled&) {}
+    }
+
+    ReduceResult result;
+    result.sum = std::accumulate(partial_sums.begin(), partial_sums.end(), 0);
+    result.processed = std::accumulate(processed.begin(), processed.end(), 0LL);
+    if (result.processed < array_size)
+        result.status = token.deadline_exceeded() ? ReduceResult::Status::DeadlineExceeded : ReduceResult::Status::Cancelled;
+    return result;
+}
+
+// ------------------ Affinity Study ------------------------------------------
+// Benchmark mode: repeated runs over a cache-resident array with a fresh pool per run,
+// a reused pool with a shared queue, and a reused pinned pool with sticky block placement.
+int runAffinityStudy(const zen::cmd_args& args) {
+    std::string thread_option;
+    int array_size = 0;
+    int runs = 200;
+    try {
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    std::vector<int> thread_counts;
+    if (thread_option.empty()) {
+        for (int t = 1; t <= defaultParallelism(); t *= 2)
+            thread_counts.push_back(t);
+    } else {
+        thread_counts = parseThreadCounts(thread_option);
+    }
+    if (thread_counts.empty() || runs <= 0 || array_size < 0) {
+        std::cerr << "Invalid affinity study parameters." << std::endl;
+        return 1;
+    }
+
+    std::ofstream csv_file("affinity_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open affinity_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Affinity,Threads,ArraySize,Run,Sum,Time_ms\n";
+
+    const std::vector<std::string> modes = {"fresh", "shared", "sticky"};
+    for (int n_threads : thread_counts) {
+        // By default each thread's block fills half of its L2, so the whole array fits in aggregate L2
+        const int size = array_size > 0 ? array_size
+                                        : static_cast<int>(cacheSize(2, 1024 * 1024) / 2 / sizeof(int)) * n_threads;
+        std::vector<int> arr(size);
+        fillArray(arr, "rand");
+        std::cout << "\n--- " << n_threads << " thread(s), " << size * sizeof(int) / 1024 << " KiB, "
+                  << runs << " repeated runs of reduce ---" << std::endl;
+        std::cout << std::left << std::setw(8) << "Affinity" << std::right << std::setw(14) << "Median (us)"
+                  << std::setw(10) << "GB/s" << std::setw(10) << "Speedup" << std::endl;
+        double fresh_median = 0.0;
+        for (const std::string& mode : modes) {
+            SumOptions opts;
+            opts.affinity = mode;
+            std::unique_ptr<ThreadPool> pool = makeRunPool(opts, n_threads);
+            volatile int warm = runMethod("reduce", arr, n_threads, opts, pool.get());
+            (void)warm;
+            std::vector<double> times;
+            for (int run = 0; run < runs; ++run) {
+                auto start_time = std::chrono::high_resolution_clock::now();
+                int sum = runMethod("reduce", arr, n_threads, opts, pool.get());
+                auto end_time = std::chrono::high_resolution_clock::now();
+                times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+                csv_file << mode << "," << n_threads << "," << size << "," << run + 1 << "," << sum << "," << times.back() << "\n";
+            }
+            const double median = percentile(times, 50);
+            if (mode == "fresh") fresh_median = median;
+            std::cout << std::left << std::setw(8) << mode << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(14) << median * 1000.0
+                      << std::setw(10) << static_cast<double>(size) * sizeof(int) / (median * 1e6)
+                      << std::setw(9) << fresh_median / median << "x" << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+        }
+    }
+
+    std::cout << "\nResults written to affinity_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Affinity Study --------------------------------------
+
+// ------------------ Oversubscription Study ---------------------------------
+// Voluntary and involuntary context switches of the whole process so far (-1 where unavailable).
+std::pair<long long, long long> contextSwitches() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return {usage.ru_nvcsw, usage.ru_nivcsw};
+#endif
+    return {-1, -1};
+}
+
+// Benchmark mode: sweeps from 1x to 8x the available cores for each method and pool wait strategy,
+// reporting throughput, context switches and tail latency, and flagging configurations that collapse.
+int runOversubscriptionStudy(const zen::cmd_args& args) {
+    std::string method_option = "locked,reduce";
+    std::string wait_option = "block,spin,yield,backoff";
+    std::string factor_option = "1,2,4,8";
+    int array_size = 4000000;
+    int runs = 20;
+    try {
+        if (args.is_present("--method"))
+            method_option = args.get_options("--method")[0];
+        if (args.is_present("--wait"))
+            wait_option = args.get_options("--wait")[0];
+        if (args.is_present("--factors"))
+            factor_option = args.get_options("--factors")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    auto splitList = [](const std::string& list) {
+        std::vector<std::string> items;
+        std::stringstream ss(list);
+        for (std::string item; std::getline(ss, item, ','); )
+            items.push_back(item);
+        return items;
+    };
+    const std::vector<std::string> methods = splitList(method_option);
+    const std::vector<std::string> waits = splitList(wait_option);
+    const std::vector<int> factors = parseIntList(factor_option);
+    try {
+        for (const std::string& w : waits) parseWaitStrategy(w);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    for (const std::string& m : methods) {
+        if (m == "parallel" || m.empty()) {
+            std::cerr << "Method " << m << " does not use the thread pool." << std::endl;
+            return 1;
+        }
+    }
+    if (methods.empty() || waits.empty() || factors.empty() || array_size <= 0 || runs <= 0) {
+        std::cerr << "Invalid oversubscription study parameters." << std::endl;
+        return 1;
+    }
+
+    const int cores = defaultParallelism();
+    std::vector<int> arr(array_size);
+    fillArray(arr, "rand");
+    std::cout << "Oversubscribing " << cores << " core(s), " << array_size << " elements, " << runs << " runs per configuration" << std::endl;
+
+    std::ofstream csv_file("oversubscription_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open oversubscription_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Method,Wait,Threads,Factor,Run,Sum,Time_ms,VoluntaryCS,InvoluntaryCS\n";
+
+    for (const std::string& method : methods) {
+        for (const std::string& wait : waits) {
+            std::cout << "\n--- " << method << ", wait strategy " << wait << " ---" << std::endl;
+            std::cout << std::right << std::setw(8) << "Threads" << std::setw(8) << "Factor" << std::setw(10) << "GB/s"
+                      << std::setw(12) << "p50 (ms)" << std::setw(12) << "p99 (ms)" << std::setw(12) << "Vol CS/run"
+                      << std::setw(14) << "Invol CS/run" << std::endl;
+            double baseline_p50 = 0.0, baseline_p99 = 0.0;
+            for (int factor : factors) {
+                const int n_threads = cores * factor;
+                SumOptions opts;
+                opts.affinity = "shared"; // a reused pool, so idle waiting between runs is what is measured
+                opts.wait_strategy = parseWaitStrategy(wait);
+                std::unique_ptr<ThreadPool> pool = makeRunPool(opts, n_threads);
+                volatile int warm = runMethod(method, arr, n_threads, opts, pool.get());
+                (void)warm;
+                std::vector<double> times;
+                const auto cs_before = contextSwitches();
+                for (int run = 0; run < runs; ++run) {
+                    const auto run_cs_before = contextSwitches();
+                    auto start_time = std::chrono::high_resolution_clock::now();
+                    int sum = runMethod(method, arr, n_threads, opts, pool.get());
+                    auto end_time = std::chrono::high_resolution_clock::now();
+                    const auto run_cs_after = contextSwitches();
+                    times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+                    csv_file << method << "," << wait << "," << n_threads << "," << factor << "," << run + 1 << "," << sum << ","
+                             << times.back() << "," << run_cs_after.first - run_cs_before.first << ","
+                             << run_cs_after.second - run_cs_before.second << "\n";
+                }
+                const auto cs_after = contextSwitches();
+                const double p50 = percentile(times, 50), p99 = percentile(times, 99);
+                if (baseline_p50 == 0.0) {
+                    baseline_p50 = p50;
+                    baseline_p99 = p99;
+                }
+                std::cout << std::setw(8) << n_threads << std::setw(7) << factor << "x" << std::fixed << std::setprecision(2)
+                          << std::setw(10) << static_cast<double>(array_size) * sizeof(int) / (p50 * 1e6)
+                          << std::setprecision(3) << std::setw(12) << p50 << std::setw(12) << p99 << std::setprecision(1)
+                          << std::setw(12) << static_cast<double>(cs_after.first - cs_before.first) / runs
+                          << std::setw(14) << static_cast<double>(cs_after.second - cs_before.second) / runs;
+                // Collapse: the median is more than twice as slow as at the first factor;
+                // tail collapse: the p99 is more than four times worse (e.g. spinners holding the CPU for whole time slices)
+                if (p50 > 2.0 * baseline_p50) std::cout << "  COLLAPSE";
+                else if (p99 > 4.0 * baseline_p99) std::cout << "  TAIL COLLAPSE";
+                std::cout << std::endl;
+                std::cout.unsetf(std::ios::floatfield);
+            }
+        }
+    }
+
+    std::cout << "\nResults written to oversubscription_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Oversubscription Study -----------------------------
+
+// ------------------ Cancellation Study -------------------------------------
+// Benchmark mode: measures what the cancellation token costs when it never fires, how long a
+// cancelled reduction takes to return, and how far past its deadline a deadline-bound one overshoots.
+int runCancellationStudy(const zen::cmd_args& args) {
+    std::string thread_option = std::to_string(defaultParallelism());
+    int array_size = 20000000;
+    int runs = 20;
+    int chunk = SumOptions().cancel_chunk;
+    try {
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+        if (args.is_present("--chunk"))
+            chunk = std::stoi(args.get_options("--chunk")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || array_size <= 0 || runs <= 0 || chunk <= 0) {
+        std::cerr << "Invalid cancellation study parameters." << std::endl;
+        return 1;
+    }
+
+    std::vector<int> arr(array_size);
+    fillArray(arr, "rand");
+    std::ofstream csv_file("cancellation_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open cancellation_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Threads,Run,Reduce_ms,Cancellable_ms,CancelLatency_us,DeadlineOvershoot_us,FractionProcessed\n";
+    using clock = CancellationToken::clock;
+    auto micros = [](clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+    for (int n_threads : thread_counts) {
+        ThreadPool pool(n_threads);
+        std::vector<double> plain_ms, token_ms, cancel_us, overshoot_us, fractions;
+        for (int run = 0; run < runs; ++run) {
+            SumOptions opts;
+            opts.cancel_chunk = chunk;
+            auto t0 = clock::now();
+            volatile int a = runMethod("reduce", arr, n_threads, opts, &pool);
+            auto t1 = clock::now();
+            volatile int b = runMethod("cancellable", arr, n_threads, opts, &pool);
+            auto t2 = clock::now();
+            (void)a; (void)b;
+            plain_ms.push_back(micros(t1 - t0) / 1000.0);
+            token_ms.push_back(micros(t2 - t1) / 1000.0);
+
+            // Cancel a quarter of the way into a full scan, from another thread
+            CancellationToken cancel_token;
+            clock::time_point cancelled_at;
+            std::thread canceller([&]() {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(token_ms.back() / 4));
+                cancelled_at = clock::now();
+                cancel_token.cancel();
+            });
+            ReduceResult cancelled = cancellableReduce(arr, pool, n_threads, cancel_token, chunk);
+            auto returned_at = clock::now();
+            canceller.join();
+            // A scan that finished before the cancel arrived has no cancellation latency to report
+            const double latency = (cancelled.status == ReduceResult::Status::Cancelled) ? micros(returned_at - cancelled_at) : 0.0;
+            if (cancelled.status == ReduceResult::Status::Cancelled) cancel_us.push_back(latency);
+            fractions.push_back(static_cast<double>(cancelled.processed) / array_size);
+
+            // Deadline at half of a full scan
+            CancellationToken deadline_token;
+            const auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                                     std::chrono::duration<double, std::milli>(token_ms.back() / 2));
+            deadline_token.set_deadline(deadline);
+            ReduceResult bounded = cancellableReduce(arr, pool, n_threads, deadline_token, chunk);
+            const double overshoot = (bounded.status == ReduceResult::Status::DeadlineExceeded) ? micros(clock::now() - deadline) : 0.0;
+            if (bounded.status == ReduceResult::Status::DeadlineExceeded) overshoot_us.push_back(overshoot);
+
+            csv_file << n_threads << "," << run + 1 << "," << plain_ms.back() << "," << token_ms.back() << ","
+                     << latency << "," << overshoot << "," << fractions.back() << "\n";
+        }
+
+        const double plain = percentile(plain_ms, 50), with_token = percentile(token_ms, 50);
+        std::cout << "\n--- Cancellation with " << n_threads << " thread(s), chunk " << chunk << " elements ---" << std::endl;
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Token cost:          reduce " << plain << " ms, cancellable " << with_token << " ms ("
+                  << std::setprecision(1) << (with_token / plain - 1.0) * 100.0 << "%)" << std::endl
+                  << "Cancel latency:      p50 " << percentile(cancel_us, 50) << " us, p99 " << percentile(cancel_us, 99)
+                  << " us (" << cancel_us.size() << "/" << runs << " runs cancelled mid-scan, median "
+                  << percentile(fractions, 50) * 100.0 << "% processed)" << std::endl
+                  << "Deadline overshoot:  p50 " << percentile(overshoot_us, 50) << " us, p99 " << percentile(overshoot_us, 99)
+                  << " us (" << overshoot_us.size() << "/" << runs << " runs hit the deadline)" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    }
+
+    std::cout << "\nResults written to cancellation_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Cancellation Study ---------------------------------
+
+// ------------------ Priority Study -----------------------------------------
+// Benchmark mode: issues small interactive sums while a background full-array scan keeps every worker
+// busy, comparing a single FIFO lane, priority lanes with whole-block scan tasks, and priority lanes
+// with the scan split into preemptible chunks.
+int runPriorityStudy(const zen::cmd_args& args) {
+    int n_threads = defaultParallelism();
+    int array_size = 20000000;
+    int small_size = 4096;
+    int requests = 200;
+    int chunk = SumOptions().scan_chunk;
+    try {
+        if (args.is_present("--threads"))
+            n_threads = std::stoi(args.get_options("--threads")[0]);
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--small-size"))
+            small_size = std::stoi(args.get_options("--small-size")[0]);
+        if (args.is_present("--requests"))
+            requests = std::stoi(args.get_options("--requests")[0]);
+        if (args.is_present("--chunk"))
+            chunk = std::stoi(args.get_options("--chunk")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    if (n_threads <= 0 || array_size <= 0 || small_size <= 0 || small_size > array_size || requests <= 0 || chunk <= 0) {
+        std::cerr << "Invalid priority study parameters." << std::endl;
+        return 1;
+    }
+
+    std::vector<int> arr(array_size);
+    fillArray(arr, "rand");
+    std::ofstream csv_file("priority_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open priority_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Mode,Request,Latency_us\n";
+
+    std::cout << n_threads << " thread(s), background scan of " << array_size << " elements, "
+              << requests << " small sums of " << small_size << " elements" << std::endl;
+    std::cout << std::left << std::setw(10) << "Mode" << std::right << std::setw(14) << "p50 (us)"
+              << std::setw(14) << "p99 (us)" << std::setw(14) << "max (us)" << std::setw(16) << "Scan GB/s" << std::endl;
+
+    const std::vector<std::string> modes = {"fifo", "priority", "chunked"};
+    for (const std::string& mode : modes) {
+        ThreadPool pool(n_threads);
+        const Priority scan_priority = (mode == "fifo") ? Priority::Normal : Priority::Low;
+        const Priority small_priority = (mode == "fifo") ? Priority::Normal : Priority::High;
+        std::atomic<bool> done(false);
+        std::atomic<long long> scans(0);
+
+        auto scan_start = std::chrono::high_resolution_clock::now();
+        std::thread background([&]() {
+            while (!done.load()) {
+                if (mode == "chunked") {
+                    volatile int s = chunkedReduce(arr, pool, chunk, scan_priority);
+                    (void)s;
+                } else {
+                    std::vector<int> partial_sums(n_threads, 0);
+                    std::vector<std::future<void>> futures;
+                    for (int t = 0; t < n_threads; ++t) {
+                        auto [start_index, end_index] = blockRange(t, n_threads, array_size);
+                        futures.push_back(pool.submit_with_priority(scan_priority, reduce_sum, std::ref(arr), start_index,
+                                                                    end_index, std::ref(partial_sums[t])));
+                    }
+                    for (auto& f : futures) { f.get(); }
+                }
+                scans.fetch_add(1);
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(5)); // let the scan occupy the workers
+
+        std::vector<double> latencies;
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<int> offset(0, array_size - small_size);
+        for (int r = 0; r < requests; ++r) {
+            int small_sum = 0;
+            const int start_index = offset(gen);
+            auto start_time = std::chrono::high_resolution_clock::now();
+            pool.submit_with_priority(small_priority, reduce_sum, std::ref(arr), start_index, start_index + small_size,
+                                      std::ref(small_sum)).get();
+            auto end_time = std::chrono::high_resolution_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::micro>(end_time - start_time).count());
+            csv_file << mode << "," << r + 1 << "," << latencies.back() << "\n";
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        done = true;
+        background.join();
+        const double scan_ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - scan_start).count();
+
+        std::cout << std::left << std::setw(10) << mode << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << percentile(latencies, 50) << std::setw(14) << percentile(latencies, 99)
+                  << std::setw(14) << percentile(latencies, 100) << std::setprecision(2)
+                  << std::setw(16) << static_cast<double>(scans.load()) * array_size * sizeof(int) / scan_ns << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    }
+
+    std::cout << "\nResults written to priority_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Priority Study -------------------------------------
+
+// ------------------ DRAM Bandwidth Sweep ------------------------------------
+// Co-running victim: repeatedly sums a cache-resident buffer so that the slowdown
+// it suffers next to a scan shows how much that scan pollutes the shared cache.
+class CacheVictim {
+public:
+    explicit CacheVictim(size_t bytes)
+        : data(bytes / sizeof(int), 1), stop(false), passes(0) {}
+
+    void start() {
+        stop = false;
+        passes = 0;
+        start_time = std::chrono::high_resolution_clock::now();
+        worker = std::thread([this]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                volatile int s = reduceRange(data.data(), data.size());
+                (void)s;
+                passes.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Stops the victim and returns its read throughput in GB/s.
+    double finish() {
+        stop = true;
+        worker.join();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start_time).count();
+        return static_cast<double>(passes.load()) * data.size() * sizeof(int) / ns;
+    }
+
+private:
+    static int reduceRange(const int* p, size_t n) { return std::accumulate(p, p + n, 0); }
+
+    std::vector<int> data;
+    std::atomic<bool> stop;
+    std::atomic<long long> passes;
+    std::thread worker;
+    std::chrono::high_resolution_clock::time_point start_time;
+};
+
+// Benchmark mode: compares hardware-only, software-prefetch and streaming-load scans of a
+// DRAM-sized array per thread count, plus how much each slows a cache-resident co-runner.
+int runDramSweep(const zen::cmd_args& args) {
+    const size_t llc = cacheSize(3, 32u << 20);
+    size_t array_bytes = std::min<size_t>(std::max<size_t>(4 * llc, 256u << 20), 1u << 30);
+    std::string thread_option;
+    std::string distance_option = "256,1024,4096";
+    int runs = 5;
+    try {
+        if (args.is_present("--size"))
+            array_bytes = static_cast<size_t>(std::stoll(args.get_options("--size")[0])) * sizeof(int);
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--prefetch-distance"))
+            distance_option = args.get_options("--prefetch-distance")[0];
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    std::vector<int> thread_counts;
+    if (thread_option.empty()) {
+        for (int t = 1; t <= defaultParallelism(); t *= 2)
+            thread_counts.push_back(t);
+    } else {
+        thread_counts = parseThreadCounts(thread_option);
+    }
+    std::vector<int> distances = parseIntList(distance_option);
+    if (thread_counts.empty() || distances.empty() || runs <= 0) {
+        std::cerr << "No valid thread counts, prefetch distances or runs provided." << std::endl;
+        return 1;
+    }
+
+    struct Variant { std::string label; std::string method; SumOptions opts; };
+    std::vector<Variant> variants = {{"hw-prefetch", "reduce", {}}};
+    for (int d : distances) variants.push_back({"prefetch@" + std::to_string(d), "prefetch", {d}});
+    for (int d : distances) variants.push_back({"prefetch-nta@" + std::to_string(d), "prefetch-nta", {d}});
+    variants.push_back({"stream", "stream", {}});
+
+    std::vector<int> arr(array_bytes / sizeof(int));
+    fillArray(arr, "rand");
+    CacheVictim victim(std::min<size_t>(llc / 2, 64u << 20));
+    std::cout << "Array of " << array_bytes / (1024 * 1024) << " MiB (LLC " << llc / (1024 * 1024) << " MiB)" << std::endl;
+
+    std::ofstream csv_file("dram_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open dram_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Variant,Threads,ArrayBytes,GBps,VictimRetained\n";
+
+    // Victim throughput on its own, for reference
+    victim.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const double victim_alone = victim.finish();
+
+    for (int n_threads : thread_counts) {
+        std::cout << "\n--- DRAM read bandwidth with " << n_threads << " thread(s) ---" << std::endl;
+        std::cout << std::left << std::setw(20) << "Variant" << std::right << std::setw(10) << "GB/s"
+                  << std::setw(18) << "Victim retained" << std::endl;
+        std::string best_label;
+        double best_gbps = 0.0;
+        for (const Variant& v : variants) {
+            volatile int warm = runMethod(v.method, arr, n_threads, v.opts);
+            (void)warm;
+            double best_ms = 1e300;
+            for (int run = 0; run < runs; ++run) {
+                auto start_time = std::chrono::high_resolution_clock::now();
+                volatile int s = runMethod(v.method, arr, n_threads, v.opts);
+                (void)s;
+                auto end_time = std::chrono::high_resolution_clock::now();
+                best_ms = std::min(best_ms, std::chrono::duration<double, std::milli>(end_time - start_time).count());
+            }
+            const double gbps = static_cast<double>(array_bytes) / (best_ms * 1e6);
+
+            victim.start();
+            for (int run = 0; run < runs; ++run) {
+                volatile int s = runMethod(v.method, arr, n_threads, v.opts);
+                (void)s;
+            }
+            const double retained = victim.finish() / victim_alone;
+
+            std::cout << std::left << std::setw(20) << v.label << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << gbps << std::setw(17) << retained * 100.0 << "%" << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+            csv_file << v.label << "," << n_threads << "," << array_bytes << "," << gbps << "," << retained << "\n";
+            if (gbps > best_gbps) {
+                best_gbps = gbps;
+                best_label = v.label;
+            }
+        }
+        std::cout << "Best with " << n_threads << " thread(s): " << best_label << std::endl;
+    }
+
+    std::cout << "\nResults written to dram_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End DRAM Bandwidth Sweep --------------------------------
+
+// ------------------ Interference Generators -------------------------------
+
+enum class InterferenceKind { MemoryBandwidth, CacheThrash, Spin };
+
+struct InterferenceSpec {
+    InterferenceKind kind;
+    int core; // -1 leaves the thread unpinned
+};
+
+// Parses "bw@2,llc@3,spin" into interference specs. Throws std::invalid_argument on bad input.
+std::vector<InterferenceSpec> parseInterference(const std::string& s) {
+    std::vector<InterferenceSpec> specs;
+    std::stringstream ss(s);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        const size_t at = token.find('@');
+        const std::string kind = token.substr(0, at);
+        const int core = (at == std::string::npos) ? -1 : std::stoi(token.substr(at + 1));
+        if (kind == "bw")        specs.push_back({InterferenceKind::MemoryBandwidth, core});
+        else if (kind == "llc")  specs.push_back({InterferenceKind::CacheThrash, core});
+        else if (kind == "spin") specs.push_back({InterferenceKind::Spin, core});
+        else throw std::invalid_argument("unknown interference kind: " + kind);
+    }
+    return specs;
+}
+
+// Background noisy neighbours: memory-bandwidth hogs, LLC thrashers and CPU spinners.
+class Interference {
+public:
+    explicit Interference(std::vector<InterferenceSpec> specs)
+        : specs(std::move(specs)), stop_flag(false)
+    {
+        // Each bw and llc thread gets its own buffer: they write to it unsynchronized
+        const size_t llc = cacheSize(3, 32u << 20);
+        for (const InterferenceSpec& spec : this->specs) {
+            buffers.emplace_back();
+            if (spec.kind == InterferenceKind::MemoryBandwidth)
+                buffers.back().assign(std::min<size_t>(std::max<size_t>(2 * llc, 64u << 20), 512u << 20), 1);
+            if (spec.kind == InterferenceKind::CacheThrash)
+                buffers.back().assign(std::min<size_t>(llc, 256u << 20), 1);
+        }
+    }
+
+    ~Interference() { stop(); }
+
+    void start() {
+        stop_flag = false;
+        for (size_t k = 0; k < specs.size(); ++k) {
+            const InterferenceSpec& spec = specs[k];
+            workers.emplace_back([this, kind = spec.kind, &buffer = buffers[k]]() { generate(kind, buffer); });
+            if (spec.core >= 0 && !pinThreadToCore(workers.back(), spec.core))
+                std::cerr << "Warning: could not pin interference thread to core " << spec.core << std::endl;
+        }
+    }
+
+    void stop() {
+        stop_flag = true;
+        for (std::thread& worker : workers)
+            worker.join();
+        workers.clear();
+    }
+
+    std::string describe() const {
+        std::string out;
+        for (const InterferenceSpec& spec : specs) {
+            if (!out.empty()) out += ",";
+            out += spec.kind == InterferenceKind::MemoryBandwidth ? "bw" : spec.kind == InterferenceKind::CacheThrash ? "llc" : "spin";
+            if (spec.core >= 0) out += "@" + std::to_string(spec.core);
+        }
+        return out;
+    }
+
+private:
+    void generate(InterferenceKind kind, std::vector<unsigned char>& buffer) {
+        constexpr size_t line = 64;
+        if (kind == InterferenceKind::MemoryBandwidth) {
+            // Read-modify-write one byte per cache line so every line is fetched and written back
+            while (!stop_flag.load(std::memory_order_relaxed)) {
+                for (size_t i = 0; i < buffer.size(); i += line)
+                    buffer[i]++;
+            }
+        } else if (kind == InterferenceKind::CacheThrash) {
+            // Pseudo-random line touches over an LLC-sized buffer defeat the prefetchers and evict other data
+            const size_t lines = buffer.size() / line;
+            uint64_t x = 88172645463325252ull;
+            while (!stop_flag.load(std::memory_order_relaxed)) {
+                for (int k = 0; k < 4096; ++k) {
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    buffer[(x % lines) * line]++;
+                }
+            }
+        } else {
+            volatile uint64_t spin = 0;
+            while (!stop_flag.load(std::memory_order_relaxed)) {
+                for (int k = 0; k < 4096; ++k)
+                    spin = spin * 6364136223846793005ull + 1442695040888963407ull;
+            }
+        }
+    }
+
+    std::vector<InterferenceSpec> specs;
+    std::vector<std::vector<unsigned char>> buffers; // one per spec, empty for spin
+    std::atomic<bool> stop_flag;
+    std::vector<std::thread> workers;
+};
+// ------------------ End Interference Generators ----------------------------
+
+// ------------------ Load-Balancing Study ----------------------------------
+// Synthetic per-element work: `cost` rounds of a dependent integer mix folded into the element value.
+// The result is deterministic, so every scheduler must produce the same total.
+inline int costlyElement(int value, int cost) {
+    uint32_t x = static_cast<uint32_t>(value);
+    for (int k = 0; k < cost; ++k) {
+        x = x * 1664525u + 1013904223u;
+    }
+    return value + static_cast<int>(x & 1u);
+}
+
+// Builds the per-element cost profile: "linear" ramp, a "hotspot" window, or a "heavytail" (Pareto) mix.
+std::vector<int> makeCostProfile(const std::string& pattern, size_t n, int max_cost) {
+    std::vector<int> cost(n, 1);
+    if (pattern == "linear") {
+        for (size_t i = 0; i < n; ++i)
+            cost[i] = 1 + static_cast<int>(static_cast<double>(max_cost - 1) * i / std::max<size_t>(1, n - 1));
+    } else if (pattern == "hotspot") {
+        // 5% of the elements, a quarter of the way in, carry the maximum cost
+        const size_t begin = n / 4, end = std::min(n, begin + std::max<size_t>(1, n / 20));
+        std::fill(cost.begin() + begin, cost.begin() + end, max_cost);
+    } else { // "heavytail"
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> uni(1e-9, 1.0);
+        for (size_t i = 0; i < n; ++i)
+            cost[i] = static_cast<int>(std::min<double>(max_cost, std::pow(uni(gen), -1.0 / 1.2)));
+    }
+    return cost;
+}
+
+// Runs costlyElement over arr with the given scheduler ("static", "dynamic", "guided" or "stealing").
+// busy_ms receives how long each worker spent processing elements.
+long long scheduleSum(const std::string& scheduler, const std::vector<int>& arr, const std::vector<int>& cost,
+                      int n_threads, int chunk, std::vector<double>& busy_ms) {
+    const int n = static_cast<int>(arr.size());
+    std::vector<long long> partials(n_threads, 0);
+    busy_ms.assign(n_threads, 0.0);
+    auto processRange = [&](int begin, int end) {
+        long long sum = 0;
+        for (int i = begin; i < end; ++i)
+            sum += costlyElement(arr[i], cost[i]);
+        return sum;
+    };
+
+    std::atomic<int> next(0);
+    struct StealQueue { std::mutex m; std::deque<std::pair<int, int>> chunks; };
+    std::vector<StealQueue> queues(scheduler == "stealing" ? n_threads : 0);
+    for (size_t w = 0; w < queues.size(); ++w) {
+        const auto [begin, end] = blockRange(static_cast<int>(w), n_threads, n);
+        for (int c = begin; c < end; c += chunk)
+            queues[w].chunks.emplace_back(c, std::min(c + chunk, end));
+    }
+
+    auto worker = [&](int w) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        long long sum = 0;
+        if (scheduler == "static") {
+            const auto [begin, end] = blockRange(w, n_threads, n);
+            sum = processRange(begin, end);
+        } else if (scheduler == "dynamic") {
+            for (int begin; (begin = next.fetch_add(chunk)) < n; )
+                sum += processRange(begin, std::min(begin + chunk, n));
+        } else if (scheduler == "guided") {
+            // Chunks shrink with the remaining work, down to the minimum chunk size
+            int begin = next.load();
+            while (begin < n) {
+                const int size = std::max(chunk, (n - begin) / (2 * n_threads));
+                if (next.compare_exchange_weak(begin, std::min(begin + size, n))) {
+                    sum += processRange(begin, std::min(begin + size, n));
+                    begin = next.load();
+                }
+            }
+        } else { // "stealing": own chunks from the front, steal from the back of other queues
+            for (;;) {
+                std::pair<int, int> range(-1, -1);
+                for (int k = 0; k < n_threads && range.first < 0; ++k) {
+                    StealQueue& q = queues[(w + k) % n_threads];
+                    std::lock_guard<std::mutex> lock(q.m);
+                    if (!q.chunks.empty()) {
+                        if (k == 0) { range = q.chunks.front(); q.chunks.pop_front(); }
+                        else        { range = q.chunks.back();  q.chunks.pop_back();  }
+                    }
+                }
+                if (range.first < 0) break; // no work is ever added, so one empty sweep means done
+                sum += processRange(range.first, range.second);
+            }
+        }
+        partials[w] = sum;
+        busy_ms[w] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    };
+
+    ThreadPool pool(n_threads);
+    std::vector<std::future<void>> futures;
+    for (int w = 0; w < n_threads; ++w)
+        futures.push_back(pool.submit(worker, w));
+    for (auto& f : futures) { f.get(); }
+    return std::accumulate(partials.begin(), partials.end(), 0LL);
+}
+
+// Benchmark mode: compares static blocks with dynamic, guided and work-stealing scheduling under skewed per-element cost.
+int runSkewStudy(const zen::cmd_args& args) {
+    std::vector<std::string> patterns = {"linear", "hotspot", "heavytail"};
+    std::string thread_option = "4";
+    int array_size = 1000000;
+    int max_cost = 64;
+    int chunk = 0;
+    int runs = 3;
+    try {
+        const std::vector<std::string> skew = args.get_options("--skew");
+        if (!skew.empty() && skew[0] != "all")
+            patterns = {skew[0]};
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--max-cost"))
+            max_cost = std::stoi(args.get_options("--max-cost")[0]);
+        if (args.is_present("--chunk"))
+            chunk = std::stoi(args.get_options("--chunk")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    for (const std::string& pattern : patterns) {
+        if (pattern != "linear" && pattern != "hotspot" && pattern != "heavytail") {
+            std::cerr << "Unknown skew pattern: " << pattern << std::endl;
+            return 1;
+        }
+    }
+    std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || array_size <= 0 || max_cost <= 0 || runs <= 0) {
+        std::cerr << "Invalid skew study parameters." << std::endl;
+        return 1;
+    }
+
+    std::vector<int> arr(array_size);
+    fillArray(arr, "rand");
+
+    std::ofstream csv_file("skew_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open skew_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Pattern,Scheduler,Threads,Run,Sum,Time_ms,Imbalance\n";
+
+    const std::vector<std::string> schedulers = {"static", "dynamic", "guided", "stealing"};
+    for (const std::string& pattern : patterns) {
+        const std::vector<int> cost = makeCostProfile(pattern, arr.size(), max_cost);
+        for (int n_threads : thread_counts) {
+            // Default chunk: 64 chunks per thread, enough to rebalance without much scheduling overhead
+            const int chunk_size = chunk > 0 ? chunk : std::max(1, array_size / (n_threads * 64));
+            std::cout << "\n--- Skew " << pattern << ", " << n_threads << " thread(s), chunk " << chunk_size << " ---" << std::endl;
+            std::cout << std::left << std::setw(10) << "Scheduler" << std::right << std::setw(12) << "Time (ms)"
+                      << std::setw(12) << "Imbalance" << "  Per-thread busy (ms)" << std::endl;
+            long long reference = 0;
+            for (const std::string& scheduler : schedulers) {
+                std::vector<double> busy_ms;
+                double best_ms = 1e300, best_imbalance = 0.0;
+                std::vector<double> best_busy;
+                for (int run = 0; run < runs; ++run) {
+                    auto start_time = std::chrono::high_resolution_clock::now();
+                    long long sum = scheduleSum(scheduler, arr, cost, n_threads, chunk_size, busy_ms);
+                    auto end_time = std::chrono::high_resolution_clock::now();
+                    const double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+                    // Imbalance: how far the busiest worker is above the mean (0% is perfectly balanced)
+                    const double mean = std::accumulate(busy_ms.begin(), busy_ms.end(), 0.0) / n_threads;
+                    const double imbalance = mean > 0 ? *std::max_element(busy_ms.begin(), busy_ms.end()) / mean - 1.0 : 0.0;
+                    if (scheduler == schedulers.front() && run == 0) {
+                        reference = sum;
+                    } else if (sum != reference) {
+                        std::cerr << "Scheduler " << scheduler << " produced " << sum << ", expected " << reference << std::endl;
+                        return 1;
+                    }
+                    csv_file << pattern << "," << scheduler << "," << n_threads << "," << run + 1 << ","
+                             << sum << "," << elapsed << "," << imbalance << "\n";
+                    if (elapsed < best_ms) {
+                        best_ms = elapsed;
+                        best_imbalance = imbalance;
+                        best_busy = busy_ms;
+                    }
+                }
+                std::cout << std::left << std::setw(10) << scheduler << std::right << std::fixed << std::setprecision(3)
+                          << std::setw(12) << best_ms << std::setw(11) << std::setprecision(1) << best_imbalance * 100.0 << "% ";
+                for (double b : best_busy)
+                    std::cout << " " << std::setprecision(2) << b;
+                std::cout << std::endl;
+                std::cout.unsetf(std::ios::floatfield);
+            }
+        }
+    }
+
+    std::cout << "\nResults written to skew_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Load-Balancing Study -------------------------------
+
+// ------------------ Half-Precision Storage ---------------------------------
+// 16-bit storage formats: IEEE binary16 (fp16) and bfloat16 (the upper half of a binary32).
+enum class HalfFormat { Fp16, Bf16 };
+
+// Software binary16 -> binary32 conversion (exact for every input).
+inline float halfToFloat(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);           // infinity or NaN
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else {
+        const float magnitude = mantissa * (1.0f / 16777216.0f); // zero or subnormal: mantissa * 2^-24
+        return sign ? -magnitude : magnitude;
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Software binary32 -> binary16 conversion, rounding to nearest even; overflow becomes infinity.
+inline uint16_t floatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+    if (x >= 0x7f800000) return sign | 0x7c00 | (x > 0x7f800000 ? 0x200 : 0);
+    if (x >= 0x477ff000) return sign | 0x7c00; // 65520 and above round to infinity
+    if (x < 0x38800000) {                       // below the smallest normal half
+        float magnitude;
+        std::memcpy(&magnitude, &x, sizeof(magnitude));
+        return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+    }
+    const uint32_t rounded = x + 0xfff + ((x >> 13) & 1);
+    return sign | static_cast<uint16_t>((rounded - 0x38000000) >> 13);
+}
+
+inline float bf16ToFloat(uint16_t b) {
+    const uint32_t bits = static_cast<uint32_t>(b) << 16;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// binary32 -> bfloat16, rounding to nearest even and keeping NaNs quiet.
+inline uint16_t floatToBf16(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    if ((x & 0x7fffffff) > 0x7f800000) return static_cast<uint16_t>((x >> 16) | 0x40);
+    return static_cast<uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+template<HalfFormat Format>
+inline float decodeHalf(uint16_t h) {
+    return Format == HalfFormat::Fp16 ? halfToFloat(h) : bf16ToFloat(h);
+}
+
+// Converts each element to float in software and accumulates in Acc, over 4 independent accumulators.
+template<HalfFormat Format, class Acc>
+Acc halfSumScalar(const uint16_t* data, size_t n) {
+    Acc acc[4] = {};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int u = 0; u < 4; ++u) {
+            acc[u] += decodeHalf<Format>(data[i + u]);
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] += decodeHalf<Format>(data[i]);
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+// True when halfSumVector<Format> has a vector conversion path on this target.
+template<HalfFormat Format>
+constexpr bool hasVectorHalf() {
+#if defined(__AVX2__) && defined(__F16C__)
+    return true;
+#elif defined(__AVX2__)
+    return Format == HalfFormat::Bf16;
+#else
+    return false;
+#endif
+}
+
+// Converts 8 elements per instruction (vcvtph2ps for fp16, zero-extend and shift for bf16) and
+// accumulates them directly into float or double vectors. Falls back to halfSumScalar without AVX2/F16C.
+template<HalfFormat Format, class Acc>
+Acc halfSumVector(const uint16_t* data, size_t n) {
+#if defined(__AVX2__)
+    if constexpr (hasVectorHalf<Format>()) {
+        auto widen = [data](size_t i) {
+            const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+#if defined(__F16C__)
+            if constexpr (Format == HalfFormat::Fp16) return _mm256_cvtph_ps(h);
+#endif
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+        };
+        Acc sum = 0;
+        size_t i = 0;
+        if constexpr (std::is_same_v<Acc, float>) {
+            __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+            for (; i + 32 <= n; i += 32) {
+                for (int u = 0; u < 4; ++u) acc[u] = _mm256_add_ps(acc[u], widen(i + 8 * u));
+            }
+            const __m256 total = _mm256_add_ps(_mm256_add_ps(acc[0], acc[1]), _mm256_add_ps(acc[2], acc[3]));
+            alignas(32) float lanes[8];
+            _mm256_store_ps(lanes, total);
+            for (float l : lanes) sum += l;
+        } else {
+            __m256d acc[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+            for (; i + 16 <= n; i += 16) {
+                const __m256 a = widen(i), b = widen(i + 8);
+                acc[0] = _mm256_add_pd(acc[0], _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+                acc[1] = _mm256_add_pd(acc[1], _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+                acc[2] = _mm256_add_pd(acc[2], _mm256_cvtps_pd(_mm256_castps256_ps128(b)));
+                acc[3] = _mm256_add_pd(acc[3], _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1)));
+            }
+            const __m256d total = _mm256_add_pd(_mm256_add_pd(acc[0], acc[1]), _mm256_add_pd(acc[2], acc[3]));
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, total);
+            for (double l : lanes) sum += l;
+        }
+        return sum + halfSumScalar<Format, Acc>(data + i, n - i);
+    }
+#endif
+    return halfSumScalar<Format, Acc>(data, n);
+}
+
+// fp32 storage baseline: float elements accumulated in Acc over 8 independent accumulators.
+template<class Acc>
+Acc floatSum(const float* data, size_t n) {
+    Acc acc[8] = {};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int u = 0; u < 8; ++u) {
+            acc[u] += data[i + u];
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] += data[i];
+    }
+    Acc sum = 0;
+    for (Acc a : acc) sum += a;
+    return sum;
+}
+
+// Benchmark mode: sums the same telemetry-like values stored as fp32, fp16 and bf16, with vectorized
+// and software conversion into float and double accumulators; reports elements/s and the error
+// against the exact sum and against fp32 storage with the same accumulator.
+int runPrecisionStudy(const zen::cmd_args& args) {
+    std::string thread_option = std::to_string(defaultParallelism());
+    int array_size = 20000000;
+    int runs = 5;
+    try {
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || array_size <= 0 || runs <= 0) {
+        std::cerr << "Invalid precision study parameters." << std::endl;
+        return 1;
+    }
+
+    // Positive, sensor-like readings around 1.0, so relative errors are meaningful
+    std::vector<float> values(array_size);
+    std::mt19937 gen(42);
+    std::normal_distribution<float> reading(1.0f, 0.25f);
+    for (float& v : values) v = std::abs(reading(gen));
+    std::vector<uint16_t> fp16(array_size), bf16(array_size);
+    std::transform(values.begin(), values.end(), fp16.begin(), floatToHalf);
+    std::transform(values.begin(), values.end(), bf16.begin(), floatToBf16);
+    long double exact = 0;
+    for (float v : values) exact += v;
+
+    struct Variant {
+        std::string storage, conversion, accumulator;
+        size_t element_bytes;
+        std::function<double(size_t, size_t)> block_sum;
+    };
+    const std::string vector_fp16 = hasVectorHalf<HalfFormat::Fp16>() ? "f16c" : "software*";
+    const std::string vector_bf16 = hasVectorHalf<HalfFormat::Bf16>() ? "avx2" : "software*";
+    const float* f32 = values.data();
+    const uint16_t* h16 = fp16.data();
+    const uint16_t* b16 = bf16.data();
+    const std::vector<Variant> variants = {
+        {"fp32", "none", "float", 4, [=](size_t b, size_t e) { return double(floatSum<float>(f32 + b, e - b)); }},
+        {"fp32", "none", "double", 4, [=](size_t b, size_t e) { return floatSum<double>(f32 + b, e - b); }},
+        {"fp16", vector_fp16, "float", 2, [=](size_t b, size_t e) { return double(halfSumVector<HalfFormat::Fp16, float>(h16 + b, e - b)); }},
+        {"fp16", vector_fp16, "double", 2, [=](size_t b, size_t e) { return halfSumVector<HalfFormat::Fp16, double>(h16 + b, e - b); }},
+        {"fp16", "software", "float", 2, [=](size_t b, size_t e) { return double(halfSumScalar<HalfFormat::Fp16, float>(h16 + b, e - b)); }},
+        {"fp16", "software", "double", 2, [=](size_t b, size_t e) { return halfSumScalar<HalfFormat::Fp16, double>(h16 + b, e - b); }},
+        {"bf16", vector_bf16, "float", 2, [=](size_t b, size_t e) { return double(halfSumVector<HalfFormat::Bf16, float>(b16 + b, e - b)); }},
+        {"bf16", vector_bf16, "double", 2, [=](size_t b, size_t e) { return halfSumVector<HalfFormat::Bf16, double>(b16 + b, e - b); }},
+        {"bf16", "software", "float", 2, [=](size_t b, size_t e) { return double(halfSumScalar<HalfFormat::Bf16, float>(b16 + b, e - b)); }},
+        {"bf16", "software", "double", 2, [=](size_t b, size_t e) { return halfSumScalar<HalfFormat::Bf16, double>(b16 + b, e - b); }},
+    };
+
+    std::ofstream csv_file("precision_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open precision_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Storage,Conversion,Accumulator,Threads,Run,Sum,Time_ms,RelErrExact,RelErrFp32\n";
+
+    for (int n_threads : thread_counts) {
+        ThreadPool pool(n_threads);
+        auto parallelSum = [&](const Variant& v) {
+            std::vector<double> partial_sums(n_threads, 0.0);
+            std::vector<std::future<void>> futures;
+            for (int t = 0; t < n_threads; ++t) {
+                auto [start_index, end_index] = blockRange(t, n_threads, array_size);
+                futures.push_back(pool.submit([&, t, start_index = start_index, end_index = end_index]() {
+                    partial_sums[t] = v.block_sum(start_index, end_index);
+                }));
+            }
+            for (auto& f : futures) { f.get(); }
+            return std::accumulate(partial_sums.begin(), partial_sums.end(), 0.0);
+        };
+
+        std::cout << "\n--- Precision study with " << n_threads << " thread(s), " << array_size << " elements ---" << std::endl;
+        std::cout << std::left << std::setw(9) << "Storage" << std::setw(12) << "Conversion" << std::setw(8) << "Acc"
+                  << std::right << std::setw(11) << "p50 ms" << std::setw(12) << "Melem/s" << std::setw(10) << "GB/s"
+                  << std::setw(14) << "RelErr exact" << std::setw(14) << "RelErr fp32" << std::endl;
+        std::map<std::string, double> fp32_sums; // fp32 storage result per accumulator
+        for (const Variant& v : variants) {
+            volatile double warm = parallelSum(v);
+            (void)warm;
+            std::vector<double> times;
+            double sum = 0.0;
+            for (int run = 0; run < runs; ++run) {
+                auto start_time = std::chrono::high_resolution_clock::now();
+                sum = parallelSum(v);
+                auto end_time = std::chrono::high_resolution_clock::now();
+                times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+            }
+            if (v.storage == "fp32") fp32_sums[v.accumulator] = sum;
+            const double err_exact = static_cast<double>(std::abs((sum - exact) / exact));
+            const double err_fp32 = std::abs(sum - fp32_sums[v.accumulator]) / fp32_sums[v.accumulator];
+            for (int run = 0; run < runs; ++run) {
+                csv_file << v.storage << "," << v.conversion << "," << v.accumulator << "," << n_threads << "," << run + 1 << ","
+                         << std::setprecision(17) << sum << std::setprecision(6) << "," << times[run] << ","
+                         << err_exact << "," << err_fp32 << "\n";
+            }
+            const double p50 = percentile(times, 50);
+            std::cout << std::left << std::setw(9) << v.storage << std::setw(12) << v.conversion << std::setw(8) << v.accumulator
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(11) << p50
+                      << std::setprecision(1) << std::setw(12) << array_size / (p50 * 1e3)
+                      << std::setprecision(2) << std::setw(10) << array_size * v.element_bytes / (p50 * 1e6)
+                      << std::scientific << std::setprecision(2) << std::setw(14) << err_exact << std::setw(14) << err_fp32 << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+        }
+    }
+    if (!hasVectorHalf<HalfFormat::Fp16>() || !hasVectorHalf<HalfFormat::Bf16>())
+        std::cout << "(software*: this build has no F16C/AVX2 conversion, so the vector path uses the software fallback)" << std::endl;
+
+    std::cout << "\nResults written to precision_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Half-Precision Storage -----------------------------
+
+// ------------------ Sparse Row Sums ----------------------------------------
+// Compressed sparse row matrix: row r's nonzeros are values[offsets[r] .. offsets[r + 1]).
+struct CsrMatrix {
+    int rows = 0;
+    std::vector<int> offsets; // rows + 1 entries
+    std::vector<int> values;
+    int nnz() const { return offsets.empty() ? 0 : offsets.back(); }
+};
+
+// Generates a CSR structure whose row lengths follow "uniform" (0 .. 2 * avg_nnz), "powerlaw"
+// (Pareto, a long tail of heavy rows) or "hub" (a handful of rows holding half of all nonzeros).
+CsrMatrix makeCsr(const std::string& distribution, int rows, int avg_nnz, std::mt19937& gen) {
+    std::vector<long long> lengths(rows, 0);
+    if (distribution == "powerlaw") {
+        std::uniform_real_distribution<double> uni(1e-9, 1.0);
+        const double scale = avg_nnz / 3.0; // mean of a Pareto with alpha 1.5 is 3x its scale
+        for (auto& len : lengths)
+            len = static_cast<long long>(std::min(scale * std::pow(uni(gen), -1.0 / 1.5), 1e8));
+    } else if (distribution == "hub") {
+        std::uniform_int_distribution<int> len(0, avg_nnz);
+        for (auto& l : lengths) l = len(gen);
+        const int hubs = std::min(rows, 4);
+        for (int h = 0; h < hubs; ++h)
+            lengths[(static_cast<long long>(h) * rows) / hubs] = static_cast<long long>(rows) * avg_nnz / (2 * hubs);
+    } else { // "uniform"
+        std::uniform_int_distribution<int> len(0, 2 * avg_nnz);
+        for (auto& l : lengths) l = len(gen);
+    }
+
+    CsrMatrix csr;
+    csr.rows = rows;
+    csr.offsets.assign(rows + 1, 0);
+    long long total = 0;
+    for (int r = 0; r < rows; ++r) {
+        total = std::min<long long>(total + lengths[r], std::numeric_limits<int>::max());
+        csr.offsets[r + 1] = static_cast<int>(total);
+    }
+    csr.values.resize(csr.nnz());
+    std::uniform_int_distribution<int> value(0, 99);
+    for (int& v : csr.values) v = value(gen);
+    return csr;
+}
+
+// Merge-path coordinate on diagonal d of the merge between row end offsets and nonzero indices:
+// returns (row, nz) where the first `row` rows and the first `nz` nonzeros have been consumed.
+std::pair<int, int> mergePathSearch(long long diagonal, const CsrMatrix& csr) {
+    long long lo = std::max<long long>(0, diagonal - csr.nnz());
+    long long hi = std::min<long long>(diagonal, csr.rows);
+    while (lo < hi) {
+        const long long mid = (lo + hi) / 2;
+        if (csr.offsets[mid + 1] <= diagonal - 1 - mid) lo = mid + 1;
+        else hi = mid;
+    }
+    return {static_cast<int>(lo), static_cast<int>(diagonal - lo)};
+}
+
+// Computes every row sum of csr on n_threads pool workers. Partitions:
+//   "rows":       equal row counts per thread
+//   "nnz":        whole rows, split where the nonzero count crosses each thread's equal share
+//   "merge-path": equal shares of rows + nonzeros, splitting long rows across threads and
+//                 fixing up the partial sums of split rows afterwards
+// busy_ms receives how long each worker spent on its share.
+void csrRowSums(const std::string& partition, const CsrMatrix& csr, ThreadPool& pool, int n_threads,
+                std::vector<long long>& row_sums, std::vector<double>& busy_ms) {
+    row_sums.assign(csr.rows, 0);
+    busy_ms.assign(n_threads, 0.0);
+    std::vector<int> carry_row(n_threads, csr.rows);
+    std::vector<long long> carry_value(n_threads, 0);
+
+    auto sumRows = [&](int begin, int end) {
+        for (int r = begin; r < end; ++r) {
+            long long sum = 0;
+            for (int k = csr.offsets[r]; k < csr.offsets[r + 1]; ++k) sum += csr.values[k];
+            row_sums[r] = sum;
+        }
+    };
+    auto worker = [&](int t) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        if (partition == "rows") {
+            const auto [begin, end] = blockRange(t, n_threads, csr.rows);
+            sumRows(begin, end);
+        } else if (partition == "nnz") {
+            auto firstRowAtShare = [&](int k) {
+                const long long share = static_cast<long long>(csr.nnz()) * k / n_threads;
+                return static_cast<int>(std::lower_bound(csr.offsets.begin(), csr.offsets.end() - 1, share) - csr.offsets.begin());
+            };
+            sumRows(t == 0 ? 0 : firstRowAtShare(t), t == n_threads - 1 ? csr.rows : firstRowAtShare(t + 1));
+        } else { // "merge-path"
+            const long long work = static_cast<long long>(csr.rows) + csr.nnz();
+            auto [row, nz] = mergePathSearch(work * t / n_threads, csr);
+            const auto [row_end, nz_end] = mergePathSearch(work * (t + 1) / n_threads, csr);
+            long long running = 0;
+            for (; row < row_end; ++row) {
+                for (; nz < csr.offsets[row + 1]; ++nz) running += csr.values[nz];
+                row_sums[row] = running;
+                running = 0;
+            }
+            // The rest of this share is the head of a row that a later thread finishes
+            for (; nz < nz_end; ++nz) running += csr.values[nz];
+            carry_row[t] = row_end;
+            carry_value[t] = running;
+        }
+        busy_ms[t] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    };
+
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < n_threads; ++t)
+        futures.push_back(pool.submit(worker, t));
+    for (auto& f : futures) { f.get(); }
+    for (int t = 0; t < n_threads; ++t) {
+        if (carry_row[t] < csr.rows) row_sums[carry_row[t]] += carry_value[t];
+    }
+}
+
+// Benchmark mode: all row sums of a generated CSR matrix under each row-length distribution and
+// partitioning; reports nonzeros/s and the busiest worker's time relative to the mean.
+int runCsrStudy(const zen::cmd_args& args) {
+    std::vector<std::string> distributions = {"uniform", "powerlaw", "hub"};
+    const std::vector<std::string> partitions = {"rows", "nnz", "merge-path"};
+    std::string thread_option = std::to_string(defaultParallelism());
+    int rows = 1000000;
+    int avg_nnz = 16;
+    int runs = 5;
+    try {
+        const std::vector<std::string> csr = args.get_options("--csr");
+        if (!csr.empty() && csr[0] != "all")
+            distributions = {csr[0]};
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--rows"))
+            rows = std::stoi(args.get_options("--rows")[0]);
+        if (args.is_present("--avg-nnz"))
+            avg_nnz = std::stoi(args.get_options("--avg-nnz")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || rows <= 0 || avg_nnz <= 0 || runs <= 0) {
+        std::cerr << "Invalid CSR study parameters." << std::endl;
+        return 1;
+    }
+    for (const auto& d : distributions) {
+        if (d != "uniform" && d != "powerlaw" && d != "hub") {
+            std::cerr << "Unknown row-length distribution: " << d << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream csv_file("csr_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open csr_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Distribution,Partition,Threads,Rows,Nnz,Run,Time_ms,NnzPerSec,Imbalance\n";
+
+    for (const auto& distribution : distributions) {
+        std::mt19937 gen(42);
+        const CsrMatrix csr = makeCsr(distribution, rows, avg_nnz, gen);
+        const int longest = [&]() {
+            int m = 0;
+            for (int r = 0; r < csr.rows; ++r) m = std::max(m, csr.offsets[r + 1] - csr.offsets[r]);
+            return m;
+        }();
+        std::vector<long long> reference(csr.rows);
+        for (int r = 0; r < csr.rows; ++r)
+            reference[r] = std::accumulate(csr.values.begin() + csr.offsets[r], csr.values.begin() + csr.offsets[r + 1], 0LL);
+
+        std::cout << "\n--- CSR row sums, " << distribution << " rows: " << csr.rows << " rows, " << csr.nnz()
+                  << " nonzeros, longest row " << longest << " ---" << std::endl;
+        std::cout << std::left << std::setw(12) << "Partition" << std::right << std::setw(8) << "Threads"
+                  << std::setw(12) << "p50 ms" << std::setw(14) << "Mnnz/s" << std::setw(12) << "Imbalance" << std::endl;
+        for (int n_threads : thread_counts) {
+            ThreadPool pool(n_threads);
+            for (const auto& partition : partitions) {
+                std::vector<long long> row_sums;
+                std::vector<double> busy_ms, times, imbalances;
+                csrRowSums(partition, csr, pool, n_threads, row_sums, busy_ms); // warm-up
+                if (row_sums != reference) {
+                    std::cerr << "Row sums from the " << partition << " partition do not match the reference" << std::endl;
+                    return 1;
+                }
+                for (int run = 0; run < runs; ++run) {
+                    auto start_time = std::chrono::high_resolution_clock::now();
+                    csrRowSums(partition, csr, pool, n_threads, row_sums, busy_ms);
+                    auto end_time = std::chrono::high_resolution_clock::now();
+                    const double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+                    const double mean_busy = std::accumulate(busy_ms.begin(), busy_ms.end(), 0.0) / n_threads;
+                    const double imbalance = mean_busy > 0 ? *std::max_element(busy_ms.begin(), busy_ms.end()) / mean_busy : 1.0;
+                    times.push_back(elapsed);
+                    imbalances.push_back(imbalance);
+                    csv_file << distribution << "," << partition << "," << n_threads << "," << csr.rows << "," << csr.nnz() << ","
+                             << run + 1 << "," << elapsed << "," << csr.nnz() / (elapsed * 1e-3) << "," << imbalance << "\n";
+                }
+                const double p50 = percentile(times, 50);
+                std::cout << std::left << std::setw(12) << partition << std::right << std::setw(8) << n_threads
+                          << std::fixed << std::setprecision(3) << std::setw(12) << p50
+                          << std::setprecision(1) << std::setw(14) << csr.nnz() / (p50 * 1e3)
+                          << std::setprecision(2) << std::setw(11) << percentile(imbalances, 50) << "x" << std::endl;
+                std::cout.unsetf(std::ios::floatfield);
+            }
+        }
+    }
+    std::cout << "(Imbalance is the busiest worker's time over the mean; 1.00x is perfectly balanced)" << std::endl;
+    std::cout << "\nResults written to csr_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Sparse Row Sums ------------------------------------
+
+// ------------------ Parallel Histogram -------------------------------------
+using Histogram = std::vector<uint32_t>;
+
+// Sub-histograms per thread for the "lanes" strategy: consecutive elements go to different copies,
+// so runs of equal keys do not serialize on one counter's store-to-load dependency.
+constexpr int kHistogramLanes = 8;
+
+// Counts keys (each in [0, bins)) on n_threads pool workers. Strategies:
+//   "private": one histogram per thread, merged at the end in parallel over bin ranges
+//   "atomic":  one shared histogram of atomic counters
+//   "lanes":   like private, with kHistogramLanes interleaved sub-histograms per thread
+Histogram buildHistogram(const std::string& strategy, const std::vector<int>& keys, int bins, ThreadPool& pool, int n_threads) {
+    const int n = static_cast<int>(keys.size());
+    Histogram result(bins, 0);
+    std::vector<std::future<void>> futures;
+    auto wait = [&futures]() {
+        for (auto& f : futures) { f.get(); }
+        futures.clear();
+    };
+
+    if (strategy == "atomic") {
+        std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[bins]());
+        for (int t = 0; t < n_threads; ++t) {
+            futures.push_back(pool.submit([&, t]() {
+                const auto [begin, end] = blockRange(t, n_threads, n);
+                for (int i = begin; i < end; ++i)
+                    counts[keys[i]].fetch_add(1, std::memory_order_relaxed);
+            }));
+        }
+        wait();
+        for (int b = 0; b < bins; ++b) result[b] = counts[b].load(std::memory_order_relaxed);
+        return result;
+    }
+
+    const bool lanes = (strategy == "lanes");
+    std::vector<Histogram> privates(n_threads);
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, n);
+            Histogram& local = privates[t];
+            if (!lanes) {
+                local.assign(bins, 0);
+                for (int i = begin; i < end; ++i) ++local[keys[i]];
+                return;
+            }
+            local.assign(static_cast<size_t>(kHistogramLanes) * bins, 0);
+            int i = begin;
+            for (; i + kHistogramLanes <= end; i += kHistogramLanes) {
+                for (int l = 0; l < kHistogramLanes; ++l) ++local[static_cast<size_t>(l) * bins + keys[i + l]];
+            }
+            for (; i < end; ++i) ++local[keys[i]];
+            for (int l = 1; l < kHistogramLanes; ++l) {
+                for (int b = 0; b < bins; ++b) local[b] += local[static_cast<size_t>(l) * bins + b];
+            }
+        }));
+    }
+    wait();
+    // Each merge task owns a range of bins, so no two tasks write the same counter
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, bins);
+            for (const Histogram& local : privates) {
+                for (int b = begin; b < end; ++b) result[b] += local[b];
+            }
+        }));
+    }
+    wait();
+    return result;
+}
+
+// Generates n keys in [0, bins): "uniform", "zipf" (rank k drawn with weight 1 / (k + 1)) or "single" (all one key).
+std::vector<int> makeHistogramKeys(const std::string& skew, int n, int bins, std::mt19937& gen) {
+    std::vector<int> keys(n, 0);
+    if (skew == "zipf") {
+        std::vector<double> weights(bins);
+        for (int k = 0; k < bins; ++k) weights[k] = 1.0 / (k + 1);
+        std::discrete_distribution<int> rank(weights.begin(), weights.end());
+        // Scatter ranks over the bins so the hot bins are not all adjacent
+        std::vector<int> bin_of_rank(bins);
+        std::iota(bin_of_rank.begin(), bin_of_rank.end(), 0);
+        std::shuffle(bin_of_rank.begin(), bin_of_rank.end(), gen);
+        for (int& k : keys) k = bin_of_rank[rank(gen)];
+    } else if (skew == "single") {
+        std::fill(keys.begin(), keys.end(), bins / 2);
+    } else { // "uniform"
+        std::uniform_int_distribution<int> key(0, bins - 1);
+        for (int& k : keys) k = key(gen);
+    }
+    return keys;
+}
+
+// Benchmark mode (--method histogram): histogram throughput of each strategy as the bin count,
+// key skew and thread count vary.
+int runHistogramStudy(const zen::cmd_args& args) {
+    std::vector<std::string> skews = {"uniform", "zipf", "single"};
+    std::vector<std::string> strategies = {"private", "atomic", "lanes"};
+    std::string thread_option = std::to_string(defaultParallelism());
+    std::string bin_option = "16,256,4096,65536,1048576";
+    int array_size = 10000000;
+    int runs = 5;
+    auto splitList = [](const std::string& s) {
+        std::vector<std::string> items;
+        std::stringstream ss(s);
+        for (std::string item; std::getline(ss, item, ',');) items.push_back(item);
+        return items;
+    };
+    try {
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--bins"))
+            bin_option = args.get_options("--bins")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+        if (args.is_present("--dist") && args.get_options("--dist")[0] != "all")
+            skews = splitList(args.get_options("--dist")[0]);
+        if (args.is_present("--strategy"))
+            strategies = splitList(args.get_options("--strategy")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    const std::vector<int> bin_counts = parseIntList(bin_option);
+    if (thread_counts.empty() || bin_counts.empty() || array_size <= 0 || runs <= 0) {
+        std::cerr << "Invalid histogram parameters." << std::endl;
+        return 1;
+    }
+    for (const auto& s : skews) {
+        if (s != "uniform" && s != "zipf" && s != "single") {
+            std::cerr << "Unknown histogram distribution: " << s << std::endl;
+            return 1;
+        }
+    }
+    for (const auto& s : strategies) {
+        if (s != "private" && s != "atomic" && s != "lanes") {
+            std::cerr << "Unknown histogram strategy: " << s << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream csv_file("histogram_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open histogram_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Distribution,Bins,Strategy,Threads,ArraySize,Run,Time_ms,MelemPerSec\n";
+
+    for (const auto& skew : skews) {
+        for (int bins : bin_counts) {
+            std::mt19937 gen(42);
+            const std::vector<int> keys = makeHistogramKeys(skew, array_size, bins, gen);
+            Histogram reference(bins, 0);
+            for (int k : keys) ++reference[k];
+
+            std::cout << "\n--- Histogram of " << array_size << " " << skew << " keys into " << bins << " bins ---" << std::endl;
+            std::cout << std::left << std::setw(10) << "Strategy" << std::right << std::setw(8) << "Threads"
+                      << std::setw(12) << "p50 ms" << std::setw(12) << "Melem/s" << std::endl;
+            for (int n_threads : thread_counts) {
+                ThreadPool pool(n_threads);
+                for (const auto& strategy : strategies) {
+                    if (buildHistogram(strategy, keys, bins, pool, n_threads) != reference) { // also the warm-up
+                        std::cerr << "Histogram from the " << strategy << " strategy does not match the reference" << std::endl;
+                        return 1;
+                    }
+                    std::vector<double> times;
+                    for (int run = 0; run < runs; ++run) {
+                        auto start_time = std::chrono::high_resolution_clock::now();
+                        volatile uint32_t first = buildHistogram(strategy, keys, bins, pool, n_threads)[0];
+                        (void)first;
+                        auto end_time = std::chrono::high_resolution_clock::now();
+                        times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+                        csv_file << skew << "," << bins << "," << strategy << "," << n_threads << "," << array_size << ","
+                                 << run + 1 << "," << times.back() << "," << array_size / (times.back() * 1e3) << "\n";
+                    }
+                    const double p50 = percentile(times, 50);
+                    std::cout << std::left << std::setw(10) << strategy << std::right << std::setw(8) << n_threads
+                              << std::fixed << std::setprecision(3) << std::setw(12) << p50
+                              << std::setprecision(1) << std::setw(12) << array_size / (p50 * 1e3) << std::endl;
+                    std::cout.unsetf(std::ios::floatfield);
+                }
+            }
+        }
+    }
+
+    std::cout << "\nResults written to histogram_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Parallel Histogram ---------------------------------
+
+// ------------------ Dictionary-Encoded Columns -----------------------------
+// A low-cardinality column stored as Code-sized indices into a table of distinct values.
+template<class Code>
+struct DictColumn {
+    std::vector<Code> codes;
+    std::vector<int> dictionary;
+};
+
+template<class Code>
+DictColumn<Code> makeDictColumn(size_t n, size_t dict_size, std::mt19937& gen) {
+    DictColumn<Code> column;
+    column.dictionary.resize(dict_size);
+    std::uniform_int_distribution<int> value(0, 999);
+    for (int& v : column.dictionary) v = value(gen);
+    column.codes.resize(n);
+    std::uniform_int_distribution<size_t> code(0, dict_size - 1);
+    for (Code& c : column.codes) c = static_cast<Code>(code(gen));
+    return column;
+}
+
+// Decode-and-sum: looks every code up in the dictionary, with AVX2 gathers of 8 codes at a time
+// where the target has them.
+template<class Code>
+long long dictGatherSum(const Code* codes, size_t n, const int* dictionary) {
+    long long sum = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    auto indices = [codes](size_t k) {
+        if constexpr (sizeof(Code) == 1) return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + k)));
+        else if constexpr (sizeof(Code) == 2) return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + k)));
+        else return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + k));
+    };
+    __m256i acc_lo = _mm256_setzero_si256(), acc_hi = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        const __m256i values = _mm256_i32gather_epi32(dictionary, indices(i), 4);
+        acc_lo = _mm256_add_epi64(acc_lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+        acc_hi = _mm256_add_epi64(acc_hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+    }
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc_lo, acc_hi));
+    for (long long l : lanes) sum += l;
+#endif
+    for (; i < n; ++i) {
+        sum += dictionary[codes[i]];
+    }
+    return sum;
+}
+
+// Count-then-multiply: counts how often each code occurs, then sums count * value once per
+// dictionary entry. Small dictionaries count into 4 interleaved tables, as the histogram "lanes"
+// strategy does, so runs of one code do not serialize on a single counter.
+template<class Code>
+long long dictCountSum(const Code* codes, size_t n, const int* dictionary, size_t dict_size) {
+    const size_t copies = dict_size <= 65536 ? 4 : 1;
+    std::vector<uint32_t> counts(copies * dict_size, 0);
+    size_t i = 0;
+    if (copies == 4) {
+        for (; i + 4 <= n; i += 4) {
+            for (size_t c = 0; c < 4; ++c) ++counts[c * dict_size + codes[i + c]];
+        }
+    }
+    for (; i < n; ++i) ++counts[codes[i]];
+    long long sum = 0;
+    for (size_t d = 0; d < dict_size; ++d) {
+        uint64_t count = 0;
+        for (size_t c = 0; c < copies; ++c) count += counts[c * dict_size + d];
+        sum += static_cast<long long>(count) * dictionary[d];
+    }
+    return sum;
+}
+
+// Sums a column with "gather" or "count" on n_threads pool workers, one block per worker.
+template<class Code>
+long long dictColumnSum(const std::string& method, const DictColumn<Code>& column, ThreadPool& pool, int n_threads) {
+    const int n = static_cast<int>(column.codes.size());
+    std::vector<long long> partial_sums(n_threads, 0);
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, n);
+            const Code* codes = column.codes.data() + begin;
+            partial_sums[t] = (method == "gather")
+                                  ? dictGatherSum(codes, end - begin, column.dictionary.data())
+                                  : dictCountSum(codes, end - begin, column.dictionary.data(), column.dictionary.size());
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+    return std::accumulate(partial_sums.begin(), partial_sums.end(), 0LL);
+}
+
+// Times both methods on one generated column and writes their rows; returns the faster method.
+template<class Code>
+std::string timeDictColumn(size_t dict_size, int array_size, int n_threads, int runs, ThreadPool& pool, std::ofstream& csv_file) {
+    std::mt19937 gen(42);
+    const DictColumn<Code> column = makeDictColumn<Code>(array_size, dict_size, gen);
+    long long reference = 0;
+    for (Code c : column.codes) reference += column.dictionary[c];
+
+    const int width = 8 * sizeof(Code);
+    std::string winner;
+    double best = 0.0;
+    for (const std::string method : {"gather", "count"}) {
+        if (dictColumnSum(method, column, pool, n_threads) != reference) // also the warm-up
+            throw std::runtime_error("dictionary " + method + " sum does not match the reference");
+        std::vector<double> times;
+        for (int run = 0; run < runs; ++run) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            volatile long long sum = dictColumnSum(method, column, pool, n_threads);
+            (void)sum;
+            auto end_time = std::chrono::high_resolution_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+            csv_file << dict_size << "," << width << "," << method << "," << n_threads << "," << array_size << ","
+                     << run + 1 << "," << times.back() << "," << array_size / (times.back() * 1e3) << "\n";
+        }
+        const double p50 = percentile(times, 50);
+        std::cout << std::setw(10) << dict_size << std::setw(7) << width << std::setw(9) << method << std::setw(8) << n_threads
+                  << std::fixed << std::setprecision(3) << std::setw(12) << p50
+                  << std::setprecision(1) << std::setw(12) << array_size / (p50 * 1e3) << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        if (winner.empty() || p50 < best) { winner = method; best = p50; }
+    }
+    return winner;
+}
+
+// Benchmark mode: sums dictionary-encoded columns by gather-decoding and by counting codes first,
+// across dictionary sizes and code widths, and reports which method wins each combination.
+int runDictStudy(const zen::cmd_args& args) {
+    std::string thread_option = std::to_string(defaultParallelism());
+    std::string dict_option = "4,16,256,4096,65536,1048576";
+    std::string width_option = "8,16,32";
+    int array_size = 20000000;
+    int runs = 5;
+    try {
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--dict-sizes"))
+            dict_option = args.get_options("--dict-sizes")[0];
+        if (args.is_present("--widths"))
+            width_option = args.get_options("--widths")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    const std::vector<int> dict_sizes = parseIntList(dict_option);
+    const std::vector<int> widths = parseIntList(width_option);
+    if (thread_counts.empty() || dict_sizes.empty() || widths.empty() || array_size <= 0 || runs <= 0) {
+        std::cerr << "Invalid dictionary study parameters." << std::endl;
+        return 1;
+    }
+    for (int w : widths) {
+        if (w != 8 && w != 16 && w != 32) {
+            std::cerr << "Code width must be 8, 16 or 32 bits (got " << w << ")" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream csv_file("dict_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open dict_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "DictSize,CodeBits,Method,Threads,ArraySize,Run,Time_ms,MelemPerSec\n";
+
+    std::vector<std::string> summary;
+    for (int n_threads : thread_counts) {
+        ThreadPool pool(n_threads);
+        std::cout << "\n--- Dictionary-encoded sum of " << array_size << " codes with " << n_threads << " thread(s) ---" << std::endl;
+        std::cout << std::setw(10) << "DictSize" << std::setw(7) << "Bits" << std::setw(9) << "Method" << std::setw(8) << "Threads"
+                  << std::setw(12) << "p50 ms" << std::setw(12) << "Melem/s" << std::endl;
+        for (int dict_size : dict_sizes) {
+            for (int width : widths) {
+                if (width < 32 && dict_size > (1 << width)) continue; // codes this narrow cannot address the dictionary
+                std::string winner;
+                try {
+                    if (width == 8)       winner = timeDictColumn<uint8_t>(dict_size, array_size, n_threads, runs, pool, csv_file);
+                    else if (width == 16) winner = timeDictColumn<uint16_t>(dict_size, array_size, n_threads, runs, pool, csv_file);
+                    else                  winner = timeDictColumn<uint32_t>(dict_size, array_size, n_threads, runs, pool, csv_file);
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                    return 1;
+                }
+                summary.push_back(std::to_string(n_threads) + " thread(s), " + std::to_string(dict_size) + " entries, " +
+                                  std::to_string(width) + "-bit codes: " + winner);
+            }
+        }
+    }
+
+    std::cout << "\n--- Faster method ---" << std::endl;
+    for (const auto& line : summary) std::cout << line << std::endl;
+    std::cout << "\nResults written to dict_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Dictionary-Encoded Columns -------------------------
+
+// ------------------ Matrix Axis Sums ---------------------------------------
+// Parses extents given as "AxBxC...", separated by 'x' or 'X', for --shape and --tensor.
+// Throws std::invalid_argument if an extent is missing, malformed or not positive.
+std::vector<int> parseExtents(const std::string& s) {
+    std::vector<int> extents;
+    size_t begin = 0;
+    while (true) {
+        const size_t end = s.find_first_of("xX", begin);
+        const std::string token = s.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        size_t used = 0;
+        const int extent = token.empty() ? 0 : std::stoi(token, &used);
+        if (used != token.size() || extent <= 0) throw std::invalid_argument("extents must be positive integers separated by x: " + s);
+        extents.push_back(extent);
+        if (end == std::string::npos) return extents;
+        begin = end + 1;
+    }
+}
+
+// Parses a matrix shape given as "RxC" into (rows, cols). Throws std::invalid_argument if malformed.
+std::pair<int, int> parseShape(const std::string& s) {
+    const std::vector<int> extents = parseExtents(s);
+    if (extents.size() != 2) throw std::invalid_argument("shape must be RxC: " + s);
+    return {extents[0], extents[1]};
+}
+
+// Sums every row of the row-major rows x cols matrix m, one contiguous block of rows per thread.
+void matrixRowSums(const std::vector<int>& m, int rows, int cols, ThreadPool& pool, int n_threads,
+                   std::vector<long long>& row_sums) {
+    row_sums.assign(rows, 0);
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, rows);
+            for (int r = begin; r < end; ++r) {
+                const int* row = m.data() + static_cast<size_t>(r) * cols;
+                long long sum = 0;
+                for (int c = 0; c < cols; ++c) sum += row[c];
+                row_sums[r] = sum;
+            }
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+}
+
+// Sums every column of the row-major rows x cols matrix m. Methods:
+//   "naive":   columns split across threads, each column walked down the rows (one element per
+//              cache line touched, no vectorization)
+//   "rowwise": rows split across threads, each adding whole rows into a private vector of column
+//              partials; contiguous, but the partials outgrow L1 once cols is large
+//   "tiled":   like rowwise, one tile of `tile` columns at a time so the partials stay in L1
+// The per-thread partials of rowwise and tiled are merged by a second pass split by columns.
+void matrixColSums(const std::string& method, const std::vector<int>& m, int rows, int cols, int tile,
+                   ThreadPool& pool, int n_threads, std::vector<long long>& col_sums) {
+    col_sums.assign(cols, 0);
+    std::vector<std::future<void>> futures;
+    if (method == "naive") {
+        for (int t = 0; t < n_threads; ++t) {
+            futures.push_back(pool.submit([&, t]() {
+                const auto [begin, end] = blockRange(t, n_threads, cols);
+                for (int c = begin; c < end; ++c) {
+                    long long sum = 0;
+                    for (int r = 0; r < rows; ++r) sum += m[static_cast<size_t>(r) * cols + c];
+                    col_sums[c] = sum;
+                }
+            }));
+        }
+        for (auto& f : futures) { f.get(); }
+        return;
+    }
+
+    const int width = method == "tiled" ? std::min(tile, cols) : cols;
+    std::vector<std::vector<long long>> partials(n_threads);
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, rows);
+            partials[t].assign(cols, 0);
+            long long* acc = partials[t].data();
+            for (int c0 = 0; c0 < cols; c0 += width) {
+                const int c1 = std::min(cols, c0 + width);
+                for (int r = begin; r < end; ++r) {
+                    const int* row = m.data() + static_cast<size_t>(r) * cols;
+                    for (int c = c0; c < c1; ++c) acc[c] += row[c];
+                }
+            }
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+    futures.clear();
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, cols);
+            for (const auto& p : partials)
+                for (int c = begin; c < end; ++c) col_sums[c] += p[c];
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+}
+
+// Benchmark mode: row and/or column sums of an R x C int matrix per method and thread count.
+// Bandwidth efficiency is each method's GB/s over a flat reduce of the same buffer.
+int runMatrixStudy(const zen::cmd_args& args) {
+    std::string thread_option = std::to_string(defaultParallelism());
+    std::string axis = "all";
+    int rows = 0, cols = 0;
+    int tile = static_cast<int>(cacheSize(1, 32 * 1024) / 2 / sizeof(long long)); // column partials in half of L1
+    int runs = 5;
+    try {
+        const auto shape = parseShape(args.get_options("--shape").at(0));
+        rows = shape.first;
+        cols = shape.second;
+        if (args.is_present("--axis"))
+            axis = args.get_options("--axis")[0];
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--tile"))
+            tile = std::stoi(args.get_options("--tile")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing command-line arguments: " << e.what() << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || tile <= 0 || runs <= 0) {
+        std::cerr << "Invalid matrix study parameters." << std::endl;
+        return 1;
+    }
+    if (axis != "row" && axis != "col" && axis != "all") {
+        std::cerr << "Unknown axis: " << axis << " (expected row, col or all)" << std::endl;
+        return 1;
+    }
+    const long long elements = static_cast<long long>(rows) * cols;
+    if (elements > std::numeric_limits<int>::max()) {
+        std::cerr << "Matrix of " << elements << " elements is too large" << std::endl;
+        return 1;
+    }
+
+    struct Variant { std::string axis; std::string method; };
+    std::vector<Variant> variants;
+    if (axis != "col") variants.push_back({"row", "rows"});
+    if (axis != "row") {
+        for (const char* method : {"naive", "rowwise", "tiled"})
+            variants.push_back({"col", method});
+    }
+
+    std::vector<int> m(static_cast<size_t>(elements));
+    fillArray(m, "rand");
+    std::vector<long long> row_reference(rows, 0), col_reference(cols, 0);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            const int v = m[static_cast<size_t>(r) * cols + c];
+            row_reference[r] += v;
+            col_reference[c] += v;
+        }
+    }
+    const double bytes = static_cast<double>(elements) * sizeof(int);
+
+    std::ofstream csv_file("matrix_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open matrix_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Axis,Method,Threads,Rows,Cols,Tile,Run,Time_ms,GBps,Efficiency\n";
+
+    std::cout << "Matrix " << rows << "x" << cols << " (" << bytes / (1024 * 1024) << " MiB), column tile " << tile << std::endl;
+    for (int n_threads : thread_counts) {
+        ThreadPool pool(n_threads);
+
+        // Flat reduce of the same buffer: the bandwidth an axis sum could reach if its shape cost nothing
+        std::vector<double> flat_times;
+        volatile int warm = runMethod("reduce", m, n_threads, {}, &pool);
+        (void)warm;
+        for (int run = 0; run < runs; ++run) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            volatile int s = runMethod("reduce", m, n_threads, {}, &pool);
+            (void)s;
+            auto end_time = std::chrono::high_resolution_clock::now();
+            flat_times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+        }
+        const double flat_gbps = bytes / (percentile(flat_times, 50) * 1e6);
+
+        std::cout << "\n--- Axis sums with " << n_threads << " thread(s), flat reduce " << std::fixed << std::setprecision(2)
+                  << flat_gbps << " GB/s ---" << std::endl;
+        std::cout << std::left << std::setw(6) << "Axis" << std::setw(10) << "Method" << std::right << std::setw(12) << "p50 ms"
+                  << std::setw(10) << "GB/s" << std::setw(12) << "Efficiency" << std::endl;
+        for (const Variant& v : variants) {
+            std::vector<long long> sums;
+            auto runVariant = [&]() {
+                if (v.axis == "row") matrixRowSums(m, rows, cols, pool, n_threads, sums);
+                else                 matrixColSums(v.method, m, rows, cols, tile, pool, n_threads, sums);
+            };
+            runVariant(); // warm-up
+            if (sums != (v.axis == "row" ? row_reference : col_reference)) {
+                std::cerr << "The " << v.method << " " << v.axis << " sums do not match the reference" << std::endl;
+                return 1;
+            }
+            std::vector<double> times;
+            for (int run = 0; run < runs; ++run) {
+                auto start_time = std::chrono::high_resolution_clock::now();
+                runVariant();
+                auto end_time = std::chrono::high_resolution_clock::now();
+                const double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+                const double gbps = bytes / (elapsed * 1e6);
+                times.push_back(elapsed);
+                csv_file << v.axis << "," << v.method << "," << n_threads << "," << rows << "," << cols << "," << tile << ","
+                         << run + 1 << "," << elapsed << "," << gbps << "," << gbps / flat_gbps << "\n";
+            }
+            const double p50 = percentile(times, 50);
+            const double gbps = bytes / (p50 * 1e6);
+            std::cout << std::left << std::setw(6) << v.axis << std::setw(10) << v.method << std::right
+                      << std::setprecision(3) << std::setw(12) << p50 << std::setprecision(2) << std::setw(10) << gbps
+                      << std::setprecision(1) << std::setw(11) << 100.0 * gbps / flat_gbps << "%" << std::endl;
+        }
+        std::cout.unsetf(std::ios::floatfield);
+    }
+    std::cout << "\nResults written to matrix_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Matrix Axis Sums -----------------------------------
+
+// ------------------ Tensor Axis Reduction ----------------------------------
+// Read-only view of an N-dimensional int tensor: element (i0, i1, ...) is data[sum(i_k * strides[k])].
+struct TensorView {
+    const int* data = nullptr;
+    std::vector<int> extents;
+    std::vector<long long> strides; // in elements, one per axis
+    int rank() const { return static_cast<int>(extents.size()); }
+};
+
+// Strides of a dense tensor whose axes are laid out in memory in `layout` order, outermost first.
+std::vector<long long> layoutStrides(const std::vector<int>& extents, const std::vector<int>& layout) {
+    std::vector<long long> strides(extents.size());
+    long long stride = 1;
+    for (auto it = layout.rbegin(); it != layout.rend(); ++it) {
+        strides[*it] = stride;
+        stride *= extents[*it];
+    }
+    return strides;
+}
+
+// One loop of a reduction nest: `extent` iterations advancing the input and output by their strides.
+// A zero output stride means the loop reduces.
+struct LoopDim {
+    int extent;
+    long long in_stride;
+    long long out_stride;
+};
+
+// Loop nest for reducing some axes of a tensor into a dense row-major tensor of the kept axes.
+struct ReductionPlan {
+    std::vector<LoopDim> dims; // outermost first; the last is the inner loop
+    int parallel_dim = 0;      // loop split across threads
+    bool private_outputs = false; // the split loop reduces, so each thread accumulates into its own output
+    size_t out_size = 1;
+    // The nest accumulates the kept axes in input stride order; when that differs from row-major
+    // order, this loop nest copies the working result into the output
+    std::vector<LoopDim> reorder;
+    int reorder_split = 0;
+};
+
+// Sorts loops by decreasing input stride, so the inner loop is the most contiguous one, and fuses
+// neighbours that walk both buffers as one longer loop.
+void orderLoops(std::vector<LoopDim>& dims) {
+    std::stable_sort(dims.begin(), dims.end(), [](const LoopDim& a, const LoopDim& b) {
+        return a.in_stride != b.in_stride ? a.in_stride > b.in_stride : a.out_stride > b.out_stride;
+    });
+    for (size_t k = dims.size() - 1; k > 0; --k) {
+        LoopDim& outer = dims[k - 1];
+        const LoopDim& inner = dims[k];
+        if (outer.in_stride == inner.in_stride * inner.extent && outer.out_stride == inner.out_stride * inner.extent) {
+            outer = {outer.extent * inner.extent, inner.in_stride, inner.out_stride};
+            dims.erase(dims.begin() + k);
+        }
+    }
+}
+
+// Picks the loop to split across threads: the longest kept loop when it gives every thread work
+// (threads then write disjoint outputs), otherwise the longest loop. The inner loop is only split
+// when it is the only one, since splitting it would cut its vectorized run short.
+int splitLoop(const std::vector<LoopDim>& dims, int n_threads) {
+    const int candidates = std::max<int>(1, static_cast<int>(dims.size()) - 1);
+    int longest = 0, longest_kept = -1;
+    for (int d = 0; d < candidates; ++d) {
+        if (dims[d].extent > dims[longest].extent) longest = d;
+        if (dims[d].out_stride != 0 && (longest_kept < 0 || dims[d].extent > dims[longest_kept].extent))
+            longest_kept = d;
+    }
+    return (longest_kept >= 0 && dims[longest_kept].extent >= n_threads) ? longest_kept : longest;
+}
+
+// Plans the reduction of the axes flagged in `reduced` on n_threads threads.
+ReductionPlan planReduction(const TensorView& in, const std::vector<bool>& reduced, int n_threads) {
+    ReductionPlan plan;
+    std::vector<int> kept;
+    for (int k = 0; k < in.rank(); ++k) {
+        if (!reduced[k]) kept.push_back(k);
+    }
+    std::vector<long long> out_strides(in.rank(), 0), work_strides(in.rank(), 0);
+    for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+        out_strides[*it] = static_cast<long long>(plan.out_size);
+        plan.out_size *= in.extents[*it];
+    }
+    std::stable_sort(kept.begin(), kept.end(), [&](int a, int b) { return in.strides[a] > in.strides[b]; });
+    long long stride = 1;
+    for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+        work_strides[*it] = stride;
+        stride *= in.extents[*it];
+    }
+
+    for (int k = 0; k < in.rank(); ++k) {
+        if (in.extents[k] > 1) plan.dims.push_back({in.extents[k], in.strides[k], work_strides[k]});
+    }
+    if (plan.dims.empty()) plan.dims.push_back({1, 1, 0});
+    orderLoops(plan.dims);
+    plan.parallel_dim = splitLoop(plan.dims, n_threads);
+    plan.private_outputs = plan.dims[plan.parallel_dim].out_stride == 0 && n_threads > 1;
+
+    if (work_strides != out_strides) {
+        // Reads the working result in output order, so the copy's writes are the contiguous side
+        for (int k : kept) {
+            if (in.extents[k] > 1) plan.reorder.push_back({in.extents[k], out_strides[k], work_strides[k]});
+        }
+        orderLoops(plan.reorder);
+        for (auto& d : plan.reorder) std::swap(d.in_stride, d.out_stride);
+        plan.reorder_split = splitLoop(plan.reorder, n_threads);
+    }
+    return plan;
+}
+
+// Runs the loop nest over [lo, hi) of the split loop and the full range of every other loop,
+// adding into out. The inner loop is specialized for contiguous reduction and contiguous copy.
+template<class T>
+void runReductionNest(const T* in, long long* out, const std::vector<LoopDim>& dims, int split, int lo, int hi) {
+    const int n = static_cast<int>(dims.size());
+    std::vector<int> first(n, 0), last(n), idx(n);
+    for (int d = 0; d < n; ++d) last[d] = dims[d].extent;
+    first[split] = lo;
+    last[split] = hi;
+    if (lo >= hi) return;
+
+    const LoopDim& inner = dims[n - 1];
+    const int count = last[n - 1] - first[n - 1];
+    long long in_off = 0, out_off = 0;
+    for (int d = 0; d < n; ++d) {
+        idx[d] = first[d];
+        in_off += first[d] * dims[d].in_stride;
+        out_off += first[d] * dims[d].out_stride;
+    }
+    for (;;) {
+        const T* p = in + in_off;
+        long long* o = out + out_off;
+        if (inner.out_stride == 0) {
+            long long sum = 0;
+            if (inner.in_stride == 1) {
+                for (int k = 0; k < count; ++k) sum += p[k];
+            } else {
+                for (int k = 0; k < count; ++k) sum += p[k * inner.in_stride];
+            }
+            *o += sum;
+        } else if (inner.in_stride == 1 && inner.out_stride == 1) {
+            for (int k = 0; k < count; ++k) o[k] += p[k];
+        } else {
+            for (int k = 0; k < count; ++k) o[k * inner.out_stride] += p[k * inner.in_stride];
+        }
+
+        // Odometer over the outer loops
+        int d = n - 2;
+        for (; d >= 0; --d) {
+            ++idx[d];
+            in_off += dims[d].in_stride;
+            out_off += dims[d].out_stride;
+            if (idx[d] < last[d]) break;
+            in_off -= static_cast<long long>(idx[d] - first[d]) * dims[d].in_stride;
+            out_off -= static_cast<long long>(idx[d] - first[d]) * dims[d].out_stride;
+            idx[d] = first[d];
+        }
+        if (d < 0) break;
+    }
+}
+
+// Reduces the planned axes of `in` on n_threads pool workers into out (row-major over the kept axes).
+void executeReduction(const TensorView& in, const ReductionPlan& plan, ThreadPool& pool, int n_threads,
+                      std::vector<long long>& out) {
+    out.assign(plan.out_size, 0);
+    std::vector<long long> work(plan.reorder.empty() ? 0 : plan.out_size, 0);
+    std::vector<long long>& result = plan.reorder.empty() ? out : work;
+    std::vector<std::vector<long long>> partials(plan.private_outputs ? n_threads : 0);
+    auto inParallel = [&](int extent, const std::function<void(int, int, int)>& body) {
+        std::vector<std::future<void>> futures;
+        for (int t = 0; t < n_threads; ++t) {
+            futures.push_back(pool.submit([&, t]() {
+                const auto [lo, hi] = blockRange(t, n_threads, extent);
+                body(t, lo, hi);
+            }));
+        }
+        for (auto& f : futures) { f.get(); }
+    };
+
+    inParallel(plan.dims[plan.parallel_dim].extent, [&](int t, int lo, int hi) {
+        long long* target = result.data();
+        if (plan.private_outputs) {
+            partials[t].assign(plan.out_size, 0);
+            target = partials[t].data();
+        }
+        runReductionNest(in.data, target, plan.dims, plan.parallel_dim, lo, hi);
+    });
+    if (plan.private_outputs) {
+        inParallel(static_cast<int>(plan.out_size), [&](int, int begin, int end) {
+            for (const auto& p : partials)
+                for (int i = begin; i < end; ++i) result[i] += p[i];
+        });
+    }
+    if (!plan.reorder.empty()) {
+        inParallel(plan.reorder[plan.reorder_split].extent, [&](int, int lo, int hi) {
+            runReductionNest(work.data(), out.data(), plan.reorder, plan.reorder_split, lo, hi);
+        });
+    }
+}
+
+// Reference reduction: nested loops in logical axis order, last axis innermost, adding element by element.
+void naiveReduction(const TensorView& in, const std::vector<bool>& reduced, std::vector<long long>& out) {
+    std::vector<LoopDim> dims;
+    size_t out_size = 1;
+    for (int k = in.rank() - 1; k >= 0; --k) {
+        dims.insert(dims.begin(), LoopDim{in.extents[k], in.strides[k], reduced[k] ? 0 : static_cast<long long>(out_size)});
+        if (!reduced[k]) out_size *= in.extents[k];
+    }
+    out.assign(out_size, 0);
+    std::vector<int> idx(dims.size(), 0);
+    const int n = static_cast<int>(dims.size());
+    long long in_off = 0, out_off = 0;
+    for (;;) {
+        out[out_off] += in.data[in_off];
+        int d = n - 1;
+        for (; d >= 0; --d) {
+            ++idx[d];
+            in_off += dims[d].in_stride;
+            out_off += dims[d].out_stride;
+            if (idx[d] < dims[d].extent) break;
+            in_off -= idx[d] * dims[d].in_stride;
+            out_off -= idx[d] * dims[d].out_stride;
+            idx[d] = 0;
+        }
+        if (d < 0) break;
+    }
+}
+
+// Benchmark mode: reduces each requested axis set of a tensor stored in every axis permutation,
+// comparing the planned engine with naive nested loops.
+int runTensorStudy(const zen::cmd_args& args) {
+    std::string thread_option = std::to_string(defaultParallelism());
+    std::vector<int> extents;
+    std::vector<std::string> axis_sets;
+    int runs = 3;
+    try {
+        extents = parseExtents(args.get_options("--tensor").at(0));
+        if (args.is_present("--axes")) {
+            std::stringstream ss(args.get_options("--axes")[0]);
+            std::string token;
+            while (std::getline(ss, token, ',')) axis_sets.push_back(token);
+        }
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing command-line arguments: " << e.what() << std::endl;
+        return 1;
+    }
+    const int rank = static_cast<int>(extents.size());
+    if (axis_sets.empty()) {
+        for (int k = 0; k < rank; ++k) axis_sets.push_back(std::to_string(k));
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || runs <= 0 || rank > 6) {
+        std::cerr << "Invalid tensor study parameters (at most 6 axes)." << std::endl;
+        return 1;
+    }
+    std::vector<std::vector<bool>> reduced_sets;
+    for (const auto& set : axis_sets) {
+        std::vector<bool> reduced(rank, false);
+        for (char c : set) {
+            const int axis = c - '0';
+            if (axis < 0 || axis >= rank) {
+                std::cerr << "Axis set '" << set << "' names an axis outside 0.." << rank - 1 << std::endl;
+                return 1;
+            }
+            reduced[axis] = true;
+        }
+        reduced_sets.push_back(reduced);
+    }
+    const long long elements = std::accumulate(extents.begin(), extents.end(), 1LL, std::multiplies<>());
+    if (elements > std::numeric_limits<int>::max()) {
+        std::cerr << "Tensor of " << elements << " elements is too large" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> data(static_cast<size_t>(elements));
+    fillArray(data, "rand");
+    const double bytes = static_cast<double>(elements) * sizeof(int);
+    auto timeMs = [&](const std::function<void()>& body) {
+        std::vector<double> times;
+        for (int run = 0; run < runs; ++run) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            body();
+            auto end_time = std::chrono::high_resolution_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end_time - start_time).count());
+        }
+        return times;
+    };
+
+    std::ofstream csv_file("tensor_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open tensor_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Shape,Layout,Axes,Method,Threads,Loops,SplitExtent,PrivateOutputs,Run,Time_ms,GBps\n";
+    const std::string shape = args.get_options("--tensor")[0];
+
+    std::vector<int> layout(rank);
+    std::iota(layout.begin(), layout.end(), 0);
+    std::vector<double> speedups;
+    std::cout << "Tensor " << shape << " (" << bytes / (1024 * 1024) << " MiB); layouts list axes outermost first" << std::endl;
+    for (int n_threads : thread_counts) {
+        ThreadPool pool(n_threads);
+        std::cout << "\n--- Axis reductions with " << n_threads << " thread(s) ---" << std::endl;
+        std::cout << std::left << std::setw(8) << "Layout" << std::setw(6) << "Axes" << std::right << std::setw(12) << "naive ms"
+                  << std::setw(12) << "engine ms" << std::setw(10) << "Speedup" << std::setw(8) << "Loops" << std::setw(14) << "Split" << std::endl;
+        do {
+            TensorView view{data.data(), extents, layoutStrides(extents, layout)};
+            std::string layout_label;
+            for (int a : layout) layout_label += std::to_string(a);
+            for (size_t s = 0; s < reduced_sets.size(); ++s) {
+                const ReductionPlan plan = planReduction(view, reduced_sets[s], n_threads);
+                std::vector<long long> expected, got;
+                naiveReduction(view, reduced_sets[s], expected);
+                executeReduction(view, plan, pool, n_threads, got);
+                if (got != expected) {
+                    std::cerr << "Engine result for layout " << layout_label << ", axes " << axis_sets[s] << " does not match the naive loops" << std::endl;
+                    return 1;
+                }
+                const std::vector<double> naive_times = timeMs([&]() { naiveReduction(view, reduced_sets[s], expected); });
+                const std::vector<double> engine_times = timeMs([&]() { executeReduction(view, plan, pool, n_threads, got); });
+                const LoopDim& split = plan.dims[plan.parallel_dim];
+                for (int run = 0; run < runs; ++run) {
+                    csv_file << shape << "," << layout_label << "," << axis_sets[s] << ",naive,1," << rank << ",0,0," << run + 1 << ","
+                             << naive_times[run] << "," << bytes / (naive_times[run] * 1e6) << "\n";
+                    csv_file << shape << "," << layout_label << "," << axis_sets[s] << ",engine," << n_threads << "," << plan.dims.size() << ","
+                             << split.extent << "," << plan.private_outputs << "," << run + 1 << ","
+                             << engine_times[run] << "," << bytes / (engine_times[run] * 1e6) << "\n";
+                }
+                const double naive_p50 = percentile(naive_times, 50), engine_p50 = percentile(engine_times, 50);
+                speedups.push_back(naive_p50 / engine_p50);
+                std::cout << std::left << std::setw(8) << layout_label << std::setw(6) << axis_sets[s] << std::right << std::fixed
+                          << std::setprecision(3) << std::setw(12) << naive_p50 << std::setw(12) << engine_p50
+                          << std::setprecision(2) << std::setw(9) << naive_p50 / engine_p50 << "x" << std::setw(8) << plan.dims.size()
+                          << std::setw(14) << ((split.out_stride == 0 ? "reduce/" : "kept/") + std::to_string(split.extent)) << std::endl;
+                std::cout.unsetf(std::ios::floatfield);
+            }
+        } while (std::next_permutation(layout.begin(), layout.end()));
+    }
+    std::cout << "\nEngine speedup over naive loops: min " << std::fixed << std::setprecision(2)
+              << *std::min_element(speedups.begin(), speedups.end()) << "x, median " << percentile(speedups, 50)
+              << "x, max " << *std::max_element(speedups.begin(), speedups.end()) << "x" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << "(Loops counts the engine's loop nest after fusing; Split is the loop divided across threads)" << std::endl;
+    std::cout << "\nResults written to tensor_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Tensor Axis Reduction ------------------------------
+
+// ------------------ Decimal Fixed-Point Sums -------------------------------
+// Two's-complement 128-bit integer with the few operations exact decimal totals need
+// (MSVC has no __int128).
+struct Int128 {
+    uint64_t lo = 0;
+    int64_t hi = 0;
+
+    Int128() = default;
+    Int128(int64_t v) : lo(static_cast<uint64_t>(v)), hi(v < 0 ? -1 : 0) {}
+
+    // hi_part * 2^32 + lo_part, the recombined halves of a split sum
+    static Int128 fromHalves(int64_t hi_part, uint64_t lo_part) {
+        Int128 r;
+        r.lo = static_cast<uint64_t>(hi_part) << 32;
+        r.hi = hi_part >> 32;
+        Int128 low;
+        low.lo = lo_part;
+        return r += low;
+    }
+
+    Int128& operator+=(const Int128& o) {
+        const uint64_t sum = lo + o.lo;
+        hi = static_cast<int64_t>(static_cast<uint64_t>(hi) + static_cast<uint64_t>(o.hi) + (sum < lo ? 1 : 0));
+        lo = sum;
+        return *this;
+    }
+    bool operator==(const Int128& o) const { return lo == o.lo && hi == o.hi; }
+    bool operator!=(const Int128& o) const { return !(*this == o); }
+    bool fitsInt64() const { return hi == (static_cast<int64_t>(lo) < 0 ? -1 : 0); }
+
+    // Decimal rendering with `scale` digits after the point.
+    std::string toString(int scale = 0) const {
+        const bool negative = hi < 0;
+        uint32_t limbs[4] = {static_cast<uint32_t>(lo), static_cast<uint32_t>(lo >> 32),
+                             static_cast<uint32_t>(static_cast<uint64_t>(hi)), static_cast<uint32_t>(static_cast<uint64_t>(hi) >> 32)};
+        if (negative) { // two's-complement negate
+            uint64_t carry = 1;
+            for (uint32_t& limb : limbs) {
+                carry += static_cast<uint32_t>(~limb);
+                limb = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+        }
+        std::string digits;
+        while (limbs[0] | limbs[1] | limbs[2] | limbs[3] || static_cast<int>(digits.size()) <= scale + (scale > 0 ? 1 : 0)) {
+            uint64_t rem = 0;
+            for (int k = 3; k >= 0; --k) {
+                const uint64_t cur = (rem << 32) | limbs[k];
+                limbs[k] = static_cast<uint32_t>(cur / 10);
+                rem = cur % 10;
+            }
+            digits.push_back(static_cast<char>('0' + rem));
+            if (scale > 0 && static_cast<int>(digits.size()) == scale) digits.push_back('.');
+        }
+        if (negative) digits.push_back('-');
+        return std::string(digits.rbegin(), digits.rend());
+    }
+};
+
+// A column of scaled decimals: the value of units[i] is units[i] / 10^scale.
+struct DecimalColumn {
+    std::string name;
+    int scale = 0;
+    std::vector<int64_t> units;
+};
+
+// Exact sum of x[0, n) for n < 2^31: the arithmetic high and unsigned low 32-bit halves are summed
+// separately, neither of which can overflow 64 bits, and recombined once.
+Int128 decimalSplitSum(const int64_t* x, size_t n) {
+    int64_t hi_sum = 0;
+    uint64_t lo_sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        hi_sum += x[i] >> 32;
+        lo_sum += static_cast<uint64_t>(x[i]) & 0xffffffffu;
+    }
+    return Int128::fromHalves(hi_sum, lo_sum);
+}
+
+// Exact sum of x[0, n): each block is summed in wrapping 64-bit arithmetic with no per-element
+// check, alongside the OR of every x + 2^(62 - b) for blocks of up to 2^b elements. Once per block,
+// that OR staying below 2^(63 - b) proves every element lies in [-2^(62 - b), 2^(62 - b)), so the
+// block sum cannot leave int64; blocks without that headroom are redone with the split sum.
+Int128 decimalBlockSum(const int64_t* x, size_t n, size_t block) {
+    int block_bits = 0;
+    while ((size_t{1} << block_bits) < block) ++block_bits;
+    const uint64_t bias = uint64_t{1} << (62 - block_bits);
+    Int128 total;
+    for (size_t begin = 0; begin < n; begin += block) {
+        const size_t len = std::min(block, n - begin);
+        const int64_t* p = x + begin;
+        uint64_t sum = 0, range = 0;
+        for (size_t i = 0; i < len; ++i) {
+            sum += static_cast<uint64_t>(p[i]);
+            range |= static_cast<uint64_t>(p[i]) + bias;
+        }
+        if ((range >> (63 - block_bits)) == 0) total += Int128(static_cast<int64_t>(sum));
+        else                                   total += decimalSplitSum(p, len);
+    }
+    return total;
+}
+
+// Sums a decimal column on n_threads pool workers. Methods:
+//   "int64": plain 64-bit sum, wrapping silently on overflow (the baseline)
+//   "split": exact, every element split into 32-bit halves
+//   "block": exact, 64-bit blocks checked for headroom once per block (block <= 2^31)
+Int128 decimalColumnSum(const std::string& method, const DecimalColumn& column, ThreadPool& pool, int n_threads, int block) {
+    const int size = static_cast<int>(column.units.size());
+    std::vector<Int128> partials(n_threads);
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < n_threads; ++t) {
+        futures.push_back(pool.submit([&, t]() {
+            const auto [begin, end] = blockRange(t, n_threads, size);
+            const int64_t* p = column.units.data() + begin;
+            const size_t n = static_cast<size_t>(end - begin);
+            if (method == "int64") {
+                uint64_t sum = 0; // unsigned, so the wrap is defined behaviour
+                for (size_t i = 0; i < n; ++i) sum += static_cast<uint64_t>(p[i]);
+                partials[t] = Int128(static_cast<int64_t>(sum));
+            } else if (method == "split") {
+                partials[t] = decimalSplitSum(p, n);
+            } else {
+                partials[t] = decimalBlockSum(p, n, static_cast<size_t>(block));
+            }
+        }));
+    }
+    for (auto& f : futures) { f.get(); }
+    if (method == "int64") { // the baseline wraps across threads too
+        uint64_t sum = 0;
+        for (const Int128& p : partials) sum += p.lo;
+        return Int128(static_cast<int64_t>(sum));
+    }
+    Int128 total;
+    for (const Int128& p : partials) total += p;
+    return total;
+}
+
+// Generates a column of `size` decimals with the given scale, uniform in [-max_units / 4, max_units].
+DecimalColumn makeDecimalColumn(const std::string& name, int scale, int64_t max_units, size_t size, std::mt19937_64& gen) {
+    DecimalColumn column{name, scale, std::vector<int64_t>(size)};
+    std::uniform_int_distribution<int64_t> value(-max_units / 4, max_units);
+    for (auto& v : column.units) v = value(gen);
+    return column;
+}
+
+// Benchmark mode: exact 128-bit decimal sums against the wrapping int64 baseline for columns of
+// increasing scale and magnitude.
+int runDecimalStudy(const zen::cmd_args& args) {
+    std::string thread_option = std::to_string(defaultParallelism());
+    int array_size = 20000000;
+    int block = 4096;
+    int runs = 5;
+    try {
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--size"))
+            array_size = std::stoi(args.get_options("--size")[0]);
+        if (args.is_present("--block"))
+            block = std::stoi(args.get_options("--block")[0]);
+        if (args.is_present("--runs"))
+            runs = std::stoi(args.get_options("--runs")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || array_size <= 0 || block <= 0 || runs <= 0) {
+        std::cerr << "Invalid decimal study parameters." << std::endl;
+        return 1;
+    }
+
+    // Cents up to ten million, micro-units up to a hundred million, and 8-decimal notionals near the
+    // int64 limit, whose total cannot fit 64 bits
+    std::mt19937_64 gen(42);
+    std::vector<DecimalColumn> columns;
+    columns.push_back(makeDecimalColumn("price", 2, 1000000000LL, array_size, gen));
+    columns.push_back(makeDecimalColumn("fx", 6, 100000000000000LL, array_size, gen));
+    columns.push_back(makeDecimalColumn("notional", 8, std::numeric_limits<int64_t>::max() / 2, array_size, gen));
+    const std::vector<std::string> methods = {"int64", "split", "block"};
+
+    std::ofstream csv_file("decimal_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open decimal_results.csv for writing." << std::endl;
+        return 1;
+    }
+    csv_file << "Column,Scale,Method,Threads,ArraySize,Block,Run,Time_ms,MelemPerSec,Exact\n";
+
+    for (const DecimalColumn& column : columns) {
+        Int128 reference;
+        for (int64_t v : column.units) reference += Int128(v);
+        std::cout << "\n--- " << column.name << " (scale " << column.scale << "): total " << reference.toString(column.scale)
+                  << (reference.fitsInt64() ? "" : ", beyond int64") << " ---" << std::endl;
+        std::cout << std::left << std::setw(8) << "Method" << std::right << std::setw(8) << "Threads" << std::setw(12) << "p50 ms"
+                  << std::setw(12) << "Melem/s" << std::setw(12) << "vs int64" << std::setw(8) << "Exact" << std::endl;
+        for (int n_threads : thread_counts) {
+            ThreadPool pool(n_threads);
+            double int64_p50 = 0.0;
+            for (const auto& method : methods) {
+                const bool exact = decimalColumnSum(method, column, pool, n_threads, block) == reference; // also the warm-up
+                if (method != "int64" && !exact) {
+                    std::cerr << "The " << method << " sum of " << column.name << " does not match the reference" << std::endl;
+                    return 1;
+                }
+                std::vector<double> times;
+                for (int run = 0; run < runs; ++run) {
+                    auto start_time = std::chrono::high_resolution_clock::now();
+                    volatile uint64_t sink = decimalColumnSum(method, column, pool, n_threads, block).lo;
+                    (void)sink;
+                    auto end_time = std::chrono::high_resolution_clock::now();
+                    const double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+                    times.push_back(elapsed);
+                    csv_file << column.name << "," << column.scale << "," << method << "," << n_threads << "," << array_size << ","
+                             << block << "," << run + 1 << "," << elapsed << "," << array_size / (elapsed * 1e3) << "," << exact << "\n";
+                }
+                const double p50 = percentile(times, 50);
+                if (method == "int64") int64_p50 = p50;
+                std::cout << std::left << std::setw(8) << method << std::right << std::setw(8) << n_threads << std::fixed
+                          << std::setprecision(3) << std::setw(12) << p50 << std::setprecision(1) << std::setw(12)
+                          << array_size / (p50 * 1e3) << std::setprecision(2) << std::setw(11) << p50 / int64_p50 << "x"
+                          << std::setw(8) << (exact ? "yes" : "no") << std::endl;
+                std::cout.unsetf(std::ios::floatfield);
+            }
+        }
+    }
+    std::cout << "(vs int64 is the time relative to the wrapping int64 sum)" << std::endl;
+    std::cout << "\nResults written to decimal_results.csv" << std::endl;
+    return 0;
+}
+// ------------------ End Decimal Fixed-Point Sums ---------------------------
+
+// ------------------ Tail-Follow Mode ---------------------------------------
+// Sums elements [first, last) of a file of native-endian int32 values, reading in 1 MiB chunks.
+long long sumFileRange(const std::filesystem::path& path, long long first, long long last) {
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(first * static_cast<long long>(sizeof(int32_t)));
+    std::vector<int32_t> buffer(1 << 18);
+    long long sum = 0;
+    for (long long at = first; at < last && in;) {
+        const long long count = std::min<long long>(buffer.size(), last - at);
+        in.read(reinterpret_cast<char*>(buffer.data()), count * sizeof(int32_t));
+        const long long got = in.gcount() / static_cast<long long>(sizeof(int32_t));
+        sum = std::accumulate(buffer.begin(), buffer.begin() + got, sum);
+        at += got;
+    }
+    return sum;
+}
+
+// Blocks until path may have changed or timeout_ms passes: inotify on Linux, a plain sleep elsewhere.
+class FileWatcher {
 public:
-    ThreadPool(size_t num_threads)
-        : stop(false)
-    {
-        for(size_t i = 0; i < num_threads; ++i) {
-            workers.emplace_back([this]() {
-                for(;;) {
-                    std::function<void()> task;
-                    
-                    {   // acquire lock
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this]() { return this->stop || !this->tasks.empty(); });
-                        if (this->stop && this->tasks.empty()) return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    
-                    // execute task
-                    task();
-                }
-            });
+    explicit FileWatcher(const std::filesystem::path& path) {
+#if defined(__linux__)
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd >= 0 && inotify_add_watch(fd, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB) < 0) {
+            close(fd);
+            fd = -1;
         }
+#else
+        (void)path;
+#endif
     }
-    
-    template<class F, class... Args>
-    auto submit(F&& f, Args&&... args)
-      -> std::future<typename std::result_of<F(Args...)>::type>
-    {
-      using return_type = typename std::result_of<F(Args...)>::type;
-      
-      auto task = std::make_shared< std::packaged_task<return_type()> >(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-      
-      std::future<return_type> res = task->get_future();
-      {
-          std::unique_lock<std::mutex> lock(queue_mutex);
-          tasks.emplace([task](){ (*task)(); });
-      }
-      condition.notify_one();
-      return res;
+    ~FileWatcher() {
+#if defined(__linux__)
+        if (fd >= 0) close(fd);
+#endif
     }
-    
-    ~ThreadPool()
-    {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool uses_inotify() const { return fd >= 0; }
+
+    void wait(int timeout_ms) {
+#if defined(__linux__)
+        if (fd >= 0) {
+            pollfd p{fd, POLLIN, 0};
+            if (poll(&p, 1, timeout_ms) > 0) {
+                char events[4096];
+                while (read(fd, events, sizeof(events)) > 0) {} // drain; the caller re-reads the size
+            }
+            return;
         }
-        condition.notify_all();
-        for(std::thread &worker: workers)
-            worker.join();
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
     }
-    
+
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
+    int fd = -1;
 };
-// ------------------ End Thread Pool ---------------------------------------
 
-// Summation functions
+// Benchmark mode: sums the existing content of an append-only file of int32 values in parallel,
+// then sums only the appended elements as the file grows. With --append-rate an internal writer
+// appends at that many elements per second, so steady-state lag can be measured without an ingest job.
+int runFollow(const zen::cmd_args& args) {
+    std::filesystem::path path;
+    std::string thread_option = std::to_string(defaultParallelism());
+    double duration_s = 10.0; // 0 follows until interrupted
+    int poll_ms = 100;
+    long long append_rate = 0;
+    int initial_size = 10000000;
+    try {
+        path = args.get_options("--follow").at(0);
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--duration"))
+            duration_s = std::stod(args.get_options("--duration")[0]);
+        if (args.is_present("--poll-ms"))
+            poll_ms = std::stoi(args.get_options("--poll-ms")[0]);
+        if (args.is_present("--append-rate"))
+            append_rate = std::stoll(args.get_options("--append-rate")[0]);
+        if (args.is_present("--size"))
+            initial_size = std::stoi(args.get_options("--size")[0]);
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
+    }
+    const std::vector<int> thread_counts = parseThreadCounts(thread_option);
+    if (thread_counts.empty() || duration_s < 0 || poll_ms <= 0 || append_rate < 0 || initial_size < 0) {
+        std::cerr << "Invalid follow parameters." << std::endl;
+        return 1;
+    }
+    const int n_threads = thread_counts[0];
 
-// 1. Locked sum: each thread uses an atomic variable for safe addition.
-void locked_sum(const std::vector<int>& arr, int start, int end, std::atomic<int>& total) {
-    int sum = 0;
-    for (int i = start; i < end; ++i) {
-        sum += arr[i];
+    std::error_code ec;
+    const bool exists = std::filesystem::exists(path, ec);
+    if (exists && append_rate > 0) {
+        std::cerr << "Refusing to append to existing file " << path.string() << "; --append-rate needs a path that does not exist yet" << std::endl;
+        return 1;
+    }
+    if (!exists) {
+        if (append_rate == 0) {
+            std::cerr << "File not found: " << path.string() << std::endl;
+            return 1;
+        }
+        // Only a missing file is ever written to, seeded with --size elements
+        std::vector<int32_t> seed_values(initial_size);
+        std::generate(seed_values.begin(), seed_values.end(), []() { return rand() % 100; });
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(seed_values.data()), seed_values.size() * sizeof(int32_t));
+        std::cout << "Created " << path.string() << " with " << initial_size << " elements" << std::endl;
     }
-    total += sum; // atomic addition is thread-safe
-}
 
-// 2. Unlocked sum: intentionally unsafe (data race) to illustrate issues.
-void unlocked_sum(const std::vector<int>& arr, int start, int end, int& total) {
-    int sum = 0;
-    for (int i = start; i < end; ++i) {
-        sum += arr[i];
+    // Catch-up: everything already in the file, one block per worker
+    using clock = std::chrono::steady_clock;
+    auto elements = [&]() { return static_cast<long long>(std::filesystem::file_size(path, ec) / sizeof(int32_t)); };
+    long long offset = elements();
+    long long total = 0;
+    auto start_time = clock::now();
+    {
+        ThreadPool pool(n_threads);
+        std::vector<long long> partial_sums(n_threads, 0);
+        std::vector<std::future<void>> futures;
+        for (int t = 0; t < n_threads; ++t) {
+            futures.push_back(pool.submit([&, t]() {
+                partial_sums[t] = sumFileRange(path, offset * t / n_threads, offset * (t + 1) / n_threads);
+            }));
+        }
+        for (auto& f : futures) { f.get(); }
+        total = std::accumulate(partial_sums.begin(), partial_sums.end(), 0LL);
     }
-    total += sum; // unsafe addition, no synchronization
-}
+    const double catchup_ms = std::chrono::duration<double, std::milli>(clock::now() - start_time).count();
+    const double catchup_mb = offset * sizeof(int32_t) / 1e6;
+    std::cout << "Catch-up: " << offset << " elements (" << catchup_mb << " MB) in " << catchup_ms << " ms with "
+              << n_threads << " thread(s), " << catchup_mb / (catchup_ms / 1e3) << " MB/s, sum " << total << std::endl;
 
-// 3. Reduce-like operation: each thread computes a partial sum.
-void reduce_sum(const std::vector<int>& arr, int start, int end, int& partial_sum) {
-    int sum = 0;
-    for (int i = start; i < end; ++i) {
-        sum += arr[i];
+    std::ofstream csv_file("follow_results.csv");
+    if (!csv_file.is_open()) {
+        std::cerr << "Failed to open follow_results.csv for writing." << std::endl;
+        return 1;
     }
-    partial_sum = sum;
-}
+    csv_file << "Elapsed_s,NewElements,TotalElements,Sum,Lag_ms\n";
 
-// 4. Parallel algorithm mode: uses C++17 parallel reduction.
-int parallel_sum(const std::vector<int>& arr) {
-#ifdef __cpp_lib_execution
-    return std::reduce(std::execution::par, arr.begin(), arr.end(), 0);
-#else
-    // If not available, fall back to sequential accumulate.
-    return std::accumulate(arr.begin(), arr.end(), 0);
-#endif
-}
+    // Optional internal appender: batches every millisecond at the requested rate
+    std::atomic<bool> stop_writer(false);
+    std::thread writer;
+    if (append_rate > 0) {
+        writer = std::thread([&]() {
+            std::ofstream out(path, std::ios::binary | std::ios::app);
+            std::vector<int32_t> batch(std::max<long long>(1, append_rate / 1000));
+            while (!stop_writer.load()) {
+                std::generate(batch.begin(), batch.end(), []() { return rand() % 100; });
+                out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(int32_t));
+                out.flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
 
-// Utility to split a comma-separated string into integers.
-std::vector<int> parseThreadCounts(const std::string& s) {
-    std::vector<int> counts;
-    std::stringstream ss(s);
-    std::string token;
-    while (std::getline(ss, token, ',')) {
-        try {
-            counts.push_back(std::stoi(token));
-        } catch (...) {
-            std::cerr << "Invalid thread count value: " << token << std::endl;
+    FileWatcher watcher(path);
+    std::cout << "Following " << path.string() << " (";
+    if (watcher.uses_inotify()) std::cout << "inotify";
+    else                        std::cout << "polling every " << poll_ms << " ms";
+    if (duration_s > 0) std::cout << ", for " << duration_s << " s";
+    std::cout << ")" << std::endl;
+    std::vector<double> lags_ms;
+    long long appended = 0;
+    const auto follow_start = clock::now();
+    while (duration_s == 0 || std::chrono::duration<double>(clock::now() - follow_start).count() < duration_s) {
+        watcher.wait(poll_ms);
+        const long long now_elements = elements();
+        if (now_elements < offset) {
+            // Truncated or rotated: start over from the beginning
+            std::cout << "File shrank from " << offset << " to " << now_elements << " elements; rescanning" << std::endl;
+            offset = 0;
+            total = 0;
         }
+        if (now_elements == offset) continue;
+        // A trailing partial element stays unread until the rest of it arrives
+        total += sumFileRange(path, offset, now_elements);
+        const long long added = now_elements - offset;
+        appended += added;
+        offset = now_elements;
+        // Lag: how long the newest write waited before the running total included it
+        const auto modified = std::filesystem::last_write_time(path, ec);
+        const double lag = ec ? 0.0 : std::chrono::duration<double, std::milli>(std::filesystem::file_time_type::clock::now() - modified).count();
+        lags_ms.push_back(std::max(0.0, lag));
+        csv_file << std::chrono::duration<double>(clock::now() - follow_start).count() << "," << added << ","
+                 << offset << "," << total << "," << lags_ms.back() << "\n";
+    }
+    if (writer.joinable()) {
+        stop_writer = true;
+        writer.join();
     }
-    return counts;
+    // Pick up the writer's final batches, then check the running total against a full rescan
+    const long long final_elements = elements();
+    if (final_elements > offset) {
+        total += sumFileRange(path, offset, final_elements);
+        appended += final_elements - offset;
+        offset = final_elements;
+    }
+    const long long rescanned = sumFileRange(path, 0, offset);
+
+    const double follow_s = std::chrono::duration<double>(clock::now() - follow_start).count();
+    std::cout << "Followed " << appended << " appended elements in " << lags_ms.size() << " update(s) over " << follow_s
+              << " s (" << appended / std::max(follow_s, 1e-9) << " elements/s)" << std::endl;
+    if (!lags_ms.empty()) {
+        std::cout << "Lag: p50 " << percentile(lags_ms, 50) << " ms, p99 " << percentile(lags_ms, 99) << " ms, max "
+                  << *std::max_element(lags_ms.begin(), lags_ms.end()) << " ms" << std::endl;
+    }
+    std::cout << "Running total " << total << (total == rescanned ? " matches" : " DOES NOT match") << " a full rescan ("
+              << rescanned << ")" << std::endl;
+    std::cout << "\nResults written to follow_results.csv" << std::endl;
+    return total == rescanned ? 0 : 1;
 }
+// ------------------ End Tail-Follow Mode -----------------------------------
 
-// Utility to fill the array based on distribution type.
-void fillArray(std::vector<int>& arr, const std::string& dist) {
-    if (dist == "sorted") {
-        for (size_t i = 0; i < arr.size(); ++i) {
-            arr[i] = static_cast<int>(i);
-        }
+// ------------------ Differential Fuzzing -----------------------------------
+// Test mode: runs every deterministic method on random configurations (size, thread count, element type,
+// distribution, alignment offset, pool placement and wait strategy) and compares each result with a
+// sequential reference. Prints the first failing configuration and returns 1 on any mismatch.
+int runFuzz(const zen::cmd_args& args) {
+    int iterations = 500;
+    unsigned seed = std::random_device{}();
+    try {
+        if (args.is_present("--iterations"))
+            iterations = std::stoi(args.get_options("--iterations")[0]);
+        if (args.is_present("--seed"))
+            seed = static_cast<unsigned>(std::stoul(args.get_options("--seed")[0]));
+    } catch (...) {
+        std::cerr << "Error parsing command-line arguments." << std::endl;
+        return 1;
     }
-    else if (dist == "reverse") {
-        for (size_t i = 0; i < arr.size(); ++i) {
-            arr[i] = static_cast<int>(arr.size() - i);
+    if (iterations <= 0) {
+        std::cerr << "Invalid fuzz parameters." << std::endl;
+        return 1;
+    }
+
+    // "unlocked" races by design and has no reference value to compare against
+    const std::vector<std::string> methods = {"locked", "reduce", "unrolled", "prefetch", "prefetch-nta", "stream", "cancellable", "chunked", "parallel"};
+    const std::vector<std::string> distributions = {"rand", "sorted", "reverse", "flags"};
+    const std::vector<std::string> placements = {"fresh", "shared", "sticky"};
+    const std::vector<WaitStrategy> strategies = {WaitStrategy::Block, WaitStrategy::Spin, WaitStrategy::Yield, WaitStrategy::Backoff};
+    const int cores = static_cast<int>(availableCores().size());
+    std::mt19937 gen(seed);
+    srand(seed); // fillArray draws from rand()
+    auto pick = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(gen); };
+    std::cout << "Fuzzing " << iterations << " configurations with seed " << seed << std::endl;
+
+    // Reused pools for shared/sticky placement, one per blocking strategy, resized between iterations.
+    // Spinning and yielding workers would burn idle cores for the whole run, so those always get a fresh pool.
+    std::unique_ptr<ThreadPool> block_pool, backoff_pool;
+    int failures = 0, checks = 0;
+
+    // Half-precision conversions: every non-NaN encoding round-trips, and the software paths
+    // match the F16C instructions bit for bit where the target has them
+    int conversion_failures = 0;
+    for (uint32_t h = 0; h <= 0xffff; ++h) {
+        const uint16_t bits = static_cast<uint16_t>(h);
+        const bool fp16_nan = (bits & 0x7c00) == 0x7c00 && (bits & 0x3ff) != 0;
+        const bool bf16_nan = (bits & 0x7f80) == 0x7f80 && (bits & 0x7f) != 0;
+        if (!fp16_nan && floatToHalf(halfToFloat(bits)) != bits) ++conversion_failures;
+        if (!bf16_nan && floatToBf16(bf16ToFloat(bits)) != bits) ++conversion_failures;
+#if defined(__F16C__)
+        const float f = halfToFloat(bits), hw = _cvtsh_ss(bits);
+        if (!fp16_nan && std::memcmp(&f, &hw, sizeof(f)) != 0) ++conversion_failures;
+#endif
+    }
+#if defined(__F16C__)
+    for (int k = 0; k < 1000000; ++k) {
+        const uint32_t x = static_cast<uint32_t>(gen());
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        if (!std::isnan(f) && floatToHalf(f) != _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT)) ++conversion_failures;
+    }
+#endif
+    checks += 1;
+    if (conversion_failures > 0) {
+        std::cerr << "FAILED half-precision conversions: " << conversion_failures << " mismatches" << std::endl;
+        ++failures;
+    }
+    // Study kernels checked against a sequential reference. Each entry draws an input for the iteration and
+    // computes its reference; every variant must then reproduce that reference exactly. Results that are not
+    // already integer vectors (histograms, 128-bit totals) are flattened into one.
+    using FuzzResult = std::vector<long long>;
+    struct FuzzInput { const std::vector<int>& arr; int n_threads; const SumOptions& opts; ThreadPool* pool; ThreadPool& reduce_pool; };
+    struct FuzzCase { FuzzResult reference; std::function<FuzzResult(const std::string& variant)> run; };
+    struct FuzzStudy { std::string name; std::vector<std::string> variants; std::function<FuzzCase(const FuzzInput&)> make; };
+    const auto int128Result = [](const Int128& v) { return FuzzResult{v.hi, static_cast<long long>(v.lo)}; };
+    const std::vector<FuzzStudy> studies = {
+        // Checked variants through runMethod: the exact total, the first block at whose end the running total
+        // leaves int range, and the wrapped int return value, on the fuzzed array and on full-range values that
+        // overflow within blocks
+        {"runMethod checked", methods, [&](const FuzzInput& in) {
+            const int block = pick(1, 1 << pick(0, 17));
+            std::vector<int> values(in.arr.size());
+            for (int& v : values) v = std::uniform_int_distribution<int>(std::numeric_limits<int>::min(), std::numeric_limits<int>::max())(gen);
+            auto full_range = std::make_shared<const std::vector<int>>(std::move(values));
+            FuzzCase c;
+            for (const std::vector<int>* data : {&in.arr, full_range.get()}) {
+                long long total = 0, first_overflow_block = -1;
+                for (size_t i = 0; i < data->size(); ++i) {
+                    total += (*data)[i];
+                    if (first_overflow_block < 0 && ((i + 1) % block == 0 || i + 1 == data->size()) &&
+                        (total > std::numeric_limits<int>::max() || total < std::numeric_limits<int>::min()))
+                        first_overflow_block = static_cast<long long>(i / block);
+                }
+                c.reference.insert(c.reference.end(), {total, first_overflow_block, static_cast<int>(static_cast<uint32_t>(total))});
+            }
+            c.run = [in, full_range, block](const std::string& method) {
+                SumOptions opts = in.opts;
+                opts.check_block = block;
+                FuzzResult got;
+                for (const std::vector<int>* data : {&in.arr, full_range.get()}) {
+                    CheckedSum result;
+                    const int wrapped = runMethod(method, *data, in.n_threads, opts, in.pool, &result);
+                    got.insert(got.end(), {result.total, result.first_overflow_block, wrapped});
+                }
+                return got;
+            };
+            return c;
+        }},
+        // The popcount methods run unchanged when checked and never report an overflow
+        {"runMethod checked", {"popcount", "popcount-hs"}, [&](const FuzzInput& in) {
+            const long long nonzero = std::count_if(in.arr.begin(), in.arr.end(), [](int v) { return v != 0; });
+            return FuzzCase{{nonzero, -1, nonzero}, [in](const std::string& method) {
+                CheckedSum result;
+                const int count = runMethod(method, in.arr, in.n_threads, in.opts, in.pool, &result);
+                return FuzzResult{result.total, result.first_overflow_block, count};
+            }};
+        }},
+        // CSR row sums, including empty matrices, empty rows and rows split across several threads
+        {"csrRowSums", {"rows", "nnz", "merge-path"}, [&](const FuzzInput& in) {
+            const std::vector<std::string> row_lengths = {"uniform", "powerlaw", "hub"};
+            auto csr = std::make_shared<const CsrMatrix>(makeCsr(row_lengths[pick(0, 2)], pick(0, 3) == 0 ? pick(0, 8) : pick(1, 5000), pick(1, 64), gen));
+            FuzzCase c;
+            for (int r = 0; r < csr->rows; ++r)
+                c.reference.push_back(std::accumulate(csr->values.begin() + csr->offsets[r], csr->values.begin() + csr->offsets[r + 1], 0LL));
+            c.run = [in, csr](const std::string& partition) {
+                FuzzResult row_sums;
+                std::vector<double> busy_ms;
+                csrRowSums(partition, *csr, in.reduce_pool, in.n_threads, row_sums, busy_ms);
+                return row_sums;
+            };
+            return c;
+        }},
+        // Histograms against a sequential count
+        {"buildHistogram", {"private", "atomic", "lanes"}, [&](const FuzzInput& in) {
+            const std::vector<std::string> skews = {"uniform", "zipf", "single"};
+            const int bins = pick(1, 1 << pick(0, 16));
+            auto keys = std::make_shared<const std::vector<int>>(makeHistogramKeys(skews[pick(0, 2)], pick(0, 3) == 0 ? pick(0, 64) : pick(0, 200000), bins, gen));
+            FuzzCase c;
+            c.reference.assign(bins, 0);
+            for (int k : *keys) ++c.reference[k];
+            c.run = [in, keys, bins](const std::string& strategy) {
+                const Histogram histogram = buildHistogram(strategy, *keys, bins, in.reduce_pool, in.n_threads);
+                return FuzzResult(histogram.begin(), histogram.end());
+            };
+            return c;
+        }},
+        // Dictionary-encoded columns against a sequential decode, at a code width wide enough for the dictionary
+        {"dictColumnSum", {"gather", "count"}, [&](const FuzzInput& in) {
+            const size_t dict_size = pick(1, 1 << pick(0, 18));
+            const size_t codes = pick(0, 3) == 0 ? pick(0, 64) : pick(0, 200000);
+            auto columnCase = [&in](auto column) {
+                auto shared = std::make_shared<const decltype(column)>(std::move(column));
+                long long reference = 0;
+                for (auto code : shared->codes) reference += shared->dictionary[code];
+                return FuzzCase{{reference}, [in, shared](const std::string& method) {
+                    return FuzzResult{dictColumnSum(method, *shared, in.reduce_pool, in.n_threads)};
+                }};
+            };
+            const int width = 8 << pick(dict_size <= 256 ? 0 : dict_size <= 65536 ? 1 : 2, 2);
+            if (width == 8) return columnCase(makeDictColumn<uint8_t>(codes, dict_size, gen));
+            if (width == 16) return columnCase(makeDictColumn<uint16_t>(codes, dict_size, gen));
+            return columnCase(makeDictColumn<uint32_t>(codes, dict_size, gen));
+        }},
+        // Tensor reductions: the planned loop nest against naive loops, for any layout and axis set
+        {"executeReduction", {"planned"}, [&](const FuzzInput& in) {
+            std::vector<int> extents(pick(1, 4)), layout(extents.size());
+            for (int& e : extents) e = pick(0, 4) == 0 ? 1 : pick(1, 12);
+            std::iota(layout.begin(), layout.end(), 0);
+            std::shuffle(layout.begin(), layout.end(), gen);
+            std::vector<bool> reduced(extents.size());
+            for (size_t k = 0; k < reduced.size(); ++k) reduced[k] = pick(0, 1) == 1;
+            auto data = std::make_shared<std::vector<int>>(std::accumulate(extents.begin(), extents.end(), size_t{1}, std::multiplies<>()));
+            for (int& v : *data) v = pick(-100, 100);
+            const TensorView view{data->data(), extents, layoutStrides(extents, layout)};
+            FuzzCase c;
+            naiveReduction(view, reduced, c.reference);
+            c.run = [in, data, view, reduced](const std::string&) {
+                FuzzResult got;
+                executeReduction(view, planReduction(view, reduced, in.n_threads), in.reduce_pool, in.n_threads, got);
+                return got;
+            };
+            return c;
+        }},
+        // Decimal sums against element-by-element 128-bit accumulation, for values of any width,
+        // including blocks that lack headroom
+        {"decimalColumnSum", {"split", "block"}, [&](const FuzzInput& in) {
+            const int bits = pick(1, 64);
+            auto column = std::make_shared<DecimalColumn>(DecimalColumn{"fuzz", pick(0, 18), std::vector<int64_t>(pick(0, 3) == 0 ? pick(0, 64) : pick(0, 100000))});
+            for (auto& v : column->units) v = static_cast<int64_t>(gen() ^ (static_cast<uint64_t>(gen()) << 32)) >> (64 - bits);
+            Int128 reference;
+            for (int64_t v : column->units) reference += Int128(v);
+            const int block = pick(1, 1 << pick(0, 16));
+            return FuzzCase{int128Result(reference), [in, column, block, int128Result](const std::string& method) {
+                return int128Result(decimalColumnSum(method, *column, in.reduce_pool, in.n_threads, block));
+            }};
+        }},
+    };
+
+    for (int it = 0; it < iterations && failures == 0; ++it) {
+        const std::string dist = distributions[pick(0, 3)];
+        // Small sizes hit empty and partial blocks; sorted/reverse totals stay within int up to 65535 elements
+        const int size = pick(0, 3) == 0 ? pick(0, 64) : (dist == "rand" || dist == "flags" ? pick(0, 1000000) : pick(0, 60000));
+        const int n_threads = pick(0, 3) == 0 ? pick(1, 16) : pick(1, std::max(1, std::min(size, 16)));
+        const int offset = pick(0, 15);
+        SumOptions opts;
+        opts.affinity = placements[pick(0, 2)];
+        opts.wait_strategy = strategies[pick(0, 3)];
+        if ((opts.wait_strategy == WaitStrategy::Spin || opts.wait_strategy == WaitStrategy::Yield) &&
+            (n_threads > cores || opts.affinity != "fresh"))
+            opts.wait_strategy = WaitStrategy::Block;
+        opts.prefetch_distance = 64 * pick(0, 32);
+        opts.cancel_chunk = pick(1, 1 << 16);
+        opts.scan_chunk = pick(1, 1 << 16);
+
+        // The offset shifts the data start away from vector alignment for the kernels checked directly
+        std::vector<int> storage(size + offset);
+        std::vector<int> arr(size);
+        fillArray(arr, dist, pick(0, 100) / 100.0);
+        std::copy(arr.begin(), arr.end(), storage.begin() + offset);
+        const long long expected = std::accumulate(arr.begin(), arr.end(), 0LL);
+
+        std::ostringstream config;
+        config << "iteration " << it << ": size=" << size << " threads=" << n_threads << " dist=" << dist
+               << " offset=" << offset << " affinity=" << opts.affinity << " wait=" << static_cast<int>(opts.wait_strategy)
+               << " prefetch=" << opts.prefetch_distance << " cancel_chunk=" << opts.cancel_chunk << " scan_chunk=" << opts.scan_chunk;
+        auto check = [&](const std::string& what, long long got, long long want) {
+            ++checks;
+            if (got == want) return;
+            if (failures++ == 0) std::cerr << "FAILED " << config.str() << std::endl;
+            std::cerr << "  " << what << ": got " << got << ", expected " << want << std::endl;
+        };
+
+        ThreadPool* pool = nullptr;
+        if (opts.affinity != "fresh") {
+            auto& slot = (opts.wait_strategy == WaitStrategy::Backoff) ? backoff_pool : block_pool;
+            if (!slot) slot = std::make_unique<ThreadPool>(n_threads, opts.wait_strategy);
+            else       slot->resize(n_threads);
+            pool = slot.get();
+        }
+        for (const auto& m : methods)
+            check(m, runMethod(m, arr, n_threads, opts, pool), expected);
+
+        // The popcount methods count non-zero elements, from a prepacked bitmap or one packed per run
+        const long long nonzero = std::count_if(arr.begin(), arr.end(), [](int v) { return v != 0; });
+        const Bitmap bitmap = packFlags(arr);
+        if (pick(0, 1) == 1) opts.bitmap = &bitmap;
+        for (const std::string m : {"popcount", "popcount-hs"})
+            check(m, runMethod(m, arr, n_threads, opts, pool), nonzero);
+        const int n_words = static_cast<int>(bitmap.words.size());
+        const int word_split = pick(0, n_words);
+        int words_head = 0, words_tail = 0;
+        harley_seal_sum(bitmap.words, 0, word_split, words_head);
+        popcount_sum(bitmap.words, word_split, n_words, words_tail);
+        check("harley_seal_sum + popcount_sum", static_cast<long long>(words_head) + words_tail, nonzero);
+
+        // Kernels on the shifted range, including a partial block at each end
+        const int start = offset, end = offset + size;
+        const int mid = start + pick(0, size);
+        int partial = 0, partial2 = 0, processed = 0;
+        reduce_sum(storage, start, end, partial);
+        check("reduce_sum", partial, expected);
+        stream_sum(storage, start, mid, partial, opts.prefetch_distance);
+        stream_sum(storage, mid, end, partial2, opts.prefetch_distance);
+        check("stream_sum", static_cast<long long>(partial) + partial2, expected);
+        prefetch_sum(storage, start, end, partial, opts.prefetch_distance, pick(0, 1) == 1);
+        check("prefetch_sum", partial, expected);
+        CancellationToken token;
+        cancellable_sum(storage, start, end, partial, processed, token, opts.cancel_chunk);
+        check("cancellable_sum", partial, expected);
+        check("cancellable_sum processed", processed, size);
+        check("unrolled_kernel<int>", unrolled_kernel<8, 8>(storage.data() + offset, static_cast<size_t>(size)), expected);
+        check("unrolled_kernel<int, 8, 2>", unrolled_kernel<8, 2>(storage.data() + offset, static_cast<size_t>(size)), expected);
+
+        // Half-precision storage: the stored values are integers, so double accumulation is exact
+        std::vector<uint16_t> as_fp16(storage.size()), as_bf16(storage.size());
+        long long fp16_expected = 0, bf16_expected = 0;
+        for (size_t i = 0; i < storage.size(); ++i) {
+            as_fp16[i] = floatToHalf(static_cast<float>(storage[i]));
+            as_bf16[i] = floatToBf16(static_cast<float>(storage[i]));
+            if (static_cast<int>(i) >= offset) {
+                fp16_expected += static_cast<long long>(halfToFloat(as_fp16[i]));
+                bf16_expected += static_cast<long long>(bf16ToFloat(as_bf16[i]));
+            }
+        }
+        const uint16_t* fp16_data = as_fp16.data() + offset;
+        const uint16_t* bf16_data = as_bf16.data() + offset;
+        check("halfSumVector<fp16>", static_cast<long long>(halfSumVector<HalfFormat::Fp16, double>(fp16_data, size)), fp16_expected);
+        check("halfSumScalar<fp16>", static_cast<long long>(halfSumScalar<HalfFormat::Fp16, double>(fp16_data, size)), fp16_expected);
+        check("halfSumVector<bf16>", static_cast<long long>(halfSumVector<HalfFormat::Bf16, double>(bf16_data, size)), bf16_expected);
+        check("halfSumScalar<bf16>", static_cast<long long>(halfSumScalar<HalfFormat::Bf16, double>(bf16_data, size)), bf16_expected);
+
+        // Floating-point element types: every value and partial sum here is an exactly representable integer
+        // for double; float is checked against the worst-case rounding bound of its accumulator chains.
+        std::vector<double> as_double(storage.begin(), storage.end());
+        check("unrolled_kernel<double>", static_cast<long long>(unrolled_kernel<8, 4>(as_double.data() + offset, static_cast<size_t>(size))), expected);
+        std::vector<float> as_float(storage.begin(), storage.end());
+        const double float_sum = unrolled_kernel<8, 4>(as_float.data() + offset, static_cast<size_t>(size));
+        ++checks;
+        const double float_bound = std::numeric_limits<float>::epsilon() * (size / 4.0 + 4.0) * static_cast<double>(expected);
+        if (std::abs(float_sum - expected) > float_bound) {
+            if (failures++ == 0) std::cerr << "FAILED " << config.str() << std::endl;
+            std::cerr << "  unrolled_kernel<float>: got " << float_sum << ", expected " << expected << std::endl;
+        }
+
+        ThreadPool reduce_pool(n_threads);
+        ReduceResult result = cancellableReduce(arr, reduce_pool, n_threads, token, opts.cancel_chunk);
+        check("cancellableReduce", result.sum, expected);
+        check("cancellableReduce processed", result.processed, size);
+        check("cancellableReduce status", static_cast<int>(result.status), static_cast<int>(ReduceResult::Status::Complete));
+
+        // Study kernels against their sequential references, from the table above
+        const FuzzInput input{arr, n_threads, opts, pool, reduce_pool};
+        for (const FuzzStudy& study : studies) {
+            const FuzzCase fuzz_case = study.make(input);
+            for (const std::string& variant : study.variants)
+                check(study.name + " " + variant + " matches", fuzz_case.run(variant) == fuzz_case.reference, 1);
+        }
+        {
+            const int64_t value = static_cast<int64_t>(gen() ^ (static_cast<uint64_t>(gen()) << 32)) >> pick(0, 63);
+            check("Int128 toString", Int128(value).toString() == std::to_string(value), 1);
+            check("Int128 toString with scale", Int128(-5).toString(3) == "-0.005" && Int128(12345).toString(2) == "123.45", 1);
+        }
+
+        // Elastic pool under load: routed and shared tasks submitted while the pool grows and shrinks all run
+        {
+            ThreadPool elastic(pick(1, 8));
+            std::atomic<bool> submitting{true};
+            std::vector<std::future<int>> results;
+            std::thread submitter([&]() {
+                std::mt19937 local_gen(seed + it);
+                for (int k = 0; submitting.load() || k < 64; ++k) {
+                    results.push_back(k % 2 ? elastic.submit_to(local_gen() % 12, [k]() { return k; })
+                                            : elastic.submit([k]() { return k; }));
+                    if (k >= 4096) break;
+                }
+            });
+            for (int r = 0; r < 16; ++r) elastic.resize(pick(1, 8));
+            submitting = false;
+            submitter.join();
+            long long lost = 0;
+            for (size_t k = 0; k < results.size(); ++k) {
+                try { lost += results[k].get() != static_cast<int>(k); } catch (const std::future_error&) { ++lost; }
+            }
+            check("elastic pool tasks lost across resizes", lost, 0);
+        }
+
+        // zen::combinable: per-thread slots from concurrent tasks fold back to the reference, and clear() starts over
+        {
+            zen::combinable<long long> sums;
+            const int tasks = pick(0, 64);
+            std::vector<std::future<void>> futures;
+            for (int k = 0; k < tasks; ++k) {
+                futures.push_back(reduce_pool.submit([&arr, &sums, k, tasks]() {
+                    const auto [begin, end] = blockRange(k, tasks, static_cast<int>(arr.size()));
+                    for (int i = begin; i < end; ++i) sums.local() += arr[i];
+                }));
+            }
+            for (auto& f : futures) { f.get(); }
+            check("combinable combine", sums.combine(std::plus<>()), tasks > 0 ? expected : 0);
+            long long slots = 0;
+            sums.combine_each([&slots](long long) { ++slots; });
+            check("combinable slots within workers", slots <= n_threads, 1);
+            sums.clear();
+            check("combinable after clear", sums.combine(std::plus<>()), 0);
+
+            // Many short-lived instances on the same long-lived workers, as chunkedReduce creates per run:
+            // each finds only its own slots, however many instances the workers have seen before
+            long long stale = 0;
+            for (int instance = 0; instance < 200; ++instance) {
+                zen::combinable<int> counts;
+                futures.clear();
+                for (int k = 0; k < n_threads; ++k)
+                    futures.push_back(reduce_pool.submit([&counts]() { ++counts.local(); }));
+                for (auto& f : futures) { f.get(); }
+                int instance_slots = 0;
+                counts.combine_each([&instance_slots](int) { ++instance_slots; });
+                if (counts.combine(std::plus<>()) != n_threads || instance_slots > n_threads) ++stale;
+            }
+            check("combinable across short-lived instances", stale, 0);
+        }
+
+        // Schedulers agree with each other on a cheap cost profile
+        if (size <= 100000) {
+            const std::vector<int> cost = makeCostProfile("heavytail", arr.size(), 4);
+            std::vector<double> busy_ms;
+            long long scheduled = 0;
+            for (size_t i = 0; i < arr.size(); ++i) scheduled += costlyElement(arr[i], cost[i]);
+            const int chunk = pick(1, 4096);
+            for (const std::string scheduler : {"static", "dynamic", "guided", "stealing"})
+                check("scheduleSum " + scheduler, scheduleSum(scheduler, arr, cost, n_threads, chunk, busy_ms), scheduled);
         }
     }
-    else { // default "rand"
-        std::generate(arr.begin(), arr.end(), []() { return rand() % 100; });
+
+    if (failures > 0) {
+        std::cerr << failures << " of " << checks << " checks failed (rerun with --seed " << seed << ")" << std::endl;
+        return 1;
     }
+    std::cout << "All " << checks << " checks passed" << std::endl;
+    return 0;
 }
+// ------------------ End Differential Fuzzing -------------------------------
 
 int main(int argc, char* argv[]) {
     // Default parameters
-    std::string method = "locked";       // locked, unlocked, reduce, parallel
-    std::string thread_option = "4";       // single value or comma-separated list (e.g., "1,2,4,8")
+    std::string method = "locked";       // locked, unlocked, reduce, unrolled, prefetch, prefetch-nta, stream, cancellable, chunked, popcount, popcount-hs, parallel (or a comma-separated list)
+    std::string thread_option = std::to_string(defaultParallelism()); // single value or comma-separated list (e.g., "1,2,4,8")
     int array_size = 10000000;
     int runs = 5;       // number of timed benchmark runs (after warmup)
     int warmup = 2;     // number of warm-up runs (not recorded)
-    std::string distribution = "rand"; // options: "rand", "sorted", "reverse"
+    std::string distribution = "rand"; // options: "rand", "sorted", "reverse", "flags"
+    double density = 0.5;              // fraction of set flags for the "flags" distribution
+    SumOptions opts;
+    std::vector<InterferenceSpec> interference_specs;
+    int profile_hz = 997; // prime, so sampling does not fall into lockstep with periodic work
+    double freq_tolerance = 5.0; // % from the configuration's median frequency before a run is flagged
     
     // Use kaizen library for cmd args (assumed available in "kaizen.h")
     zen::cmd_args args(argv, argc);
-    if (!args.is_present("--size") || !args.is_present("--threads")) {
+    if (args.is_present("--list-methods")) {
+        for (const std::string& m : kMethods) std::cout << m << "\n";
+        return 0;
+    }
+    if (args.is_present("--unroll-sweep")) {
+        return runUnrollSweep();
+    }
+    if (args.is_present("--dram-sweep")) {
+        return runDramSweep(args);
+    }
+    if (args.is_present("--skew")) {
+        return runSkewStudy(args);
+    }
+    if (args.is_present("--affinity-study")) {
+        return runAffinityStudy(args);
+    }
+    if (args.is_present("--oversubscribe")) {
+        return runOversubscriptionStudy(args);
+    }
+    if (args.is_present("--cancel-study")) {
+        return runCancellationStudy(args);
+    }
+    if (args.is_present("--priority-study")) {
+        return runPriorityStudy(args);
+    }
+    if (args.is_present("--precision-study")) {
+        return runPrecisionStudy(args);
+    }
+    if (args.is_present("--csr")) {
+        return runCsrStudy(args);
+    }
+    if (args.is_present("--dict-study")) {
+        return runDictStudy(args);
+    }
+    if (args.is_present("--shape")) {
+        return runMatrixStudy(args);
+    }
+    if (args.is_present("--tensor")) {
+        return runTensorStudy(args);
+    }
+    if (args.is_present("--decimal-study")) {
+        return runDecimalStudy(args);
+    }
+    if (args.is_present("--follow")) {
+        return runFollow(args);
+    }
+    if (args.is_present("--fuzz")) {
+        return runFuzz(args);
+    }
+    if (args.is_present("--method") && args.get_options("--method")[0] == "histogram") {
+        return runHistogramStudy(args);
+    }
+    if (!args.is_present("--size")) {
         std::cerr << "Usage: " << argv[0] 
-                  << " --threads <thread_counts (comma-separated)> --size <array_size> [--method locked|unlocked|reduce|parallel] [--runs <n>] [--warmup <n>] [--dist rand|sorted|reverse]" << std::endl;
+                  << " --size <array_size> [--threads <thread_counts (comma-separated), default: cgroup/affinity-aware core count>] [--method locked|unlocked|reduce|unrolled|prefetch|prefetch-nta|stream|cancellable|chunked|popcount|popcount-hs|parallel (comma-separated)] [--prefetch-distance <bytes>] [--runs <n>] [--warmup <n>] [--dist rand|sorted|reverse|flags] [--density <0..1>] [--interference bw|llc|spin[@core],...] [--affinity fresh|shared|sticky] [--wait block|spin|yield|backoff] [--profile [--profile-hz <n>]] [--freq-tolerance <percent>] [--checked [--check-block <n>]]" << std::endl
+                  << "       " << argv[0] << " --unroll-sweep" << std::endl
+                  << "       " << argv[0] << " --dram-sweep [--threads <list>] [--size <n>] [--prefetch-distance <list>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --skew [linear|hotspot|heavytail|all] [--threads <list>] [--size <n>] [--max-cost <n>] [--chunk <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --affinity-study [--threads <list>] [--size <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --oversubscribe [--method <list>] [--wait <list>] [--factors <list>] [--size <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --cancel-study [--threads <list>] [--size <n>] [--runs <n>] [--chunk <n>]" << std::endl
+                  << "       " << argv[0] << " --priority-study [--threads <n>] [--size <n>] [--small-size <n>] [--requests <n>] [--chunk <n>]" << std::endl
+                  << "       " << argv[0] << " --precision-study [--threads <list>] [--size <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --csr [uniform|powerlaw|hub|all] [--threads <list>] [--rows <n>] [--avg-nnz <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --method histogram [--bins <list>] [--dist uniform|zipf|single|all] [--strategy private,atomic,lanes] [--threads <list>] [--size <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --dict-study [--dict-sizes <list>] [--widths 8,16,32] [--threads <list>] [--size <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --shape <rows>x<cols> [--axis row|col|all] [--tile <cols>] [--threads <list>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --tensor <AxBxC...> [--axes <sets, e.g. 0,13>] [--threads <list>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --decimal-study [--threads <list>] [--size <n>] [--block <n>] [--runs <n>]" << std::endl
+                  << "       " << argv[0] << " --follow <file.bin> [--threads <n>] [--duration <s>] [--poll-ms <n>] [--append-rate <elements/s>] [--size <n>]" << std::endl
+                  << "       " << argv[0] << " --fuzz [--iterations <n>] [--seed <n>]" << std::endl
+                  << "       " << argv[0] << " --list-methods" << std::endl;
         return 1;
     }
     
     // Parse command-line parameters
     try {
-        thread_option = args.get_options("--threads")[0];
+        if (args.is_present("--threads"))
+            thread_option = args.get_options("--threads")[0];
         array_size = std::stoi(args.get_options("--size")[0]);
         if (args.is_present("--method"))
             method = args.get_options("--method")[0];
@@ -187,10 +5007,59 @@ int main(int argc, char* argv[]) {
             warmup = std::stoi(args.get_options("--warmup")[0]);
         if (args.is_present("--dist"))
             distribution = args.get_options("--dist")[0];
+        if (args.is_present("--density"))
+            density = std::stod(args.get_options("--density")[0]);
+        if (args.is_present("--prefetch-distance"))
+            opts.prefetch_distance = std::stoi(args.get_options("--prefetch-distance")[0]);
+        if (args.is_present("--interference"))
+            interference_specs = parseInterference(args.get_options("--interference")[0]);
+        if (args.is_present("--affinity"))
+            opts.affinity = args.get_options("--affinity")[0];
+        if (args.is_present("--wait"))
+            opts.wait_strategy = parseWaitStrategy(args.get_options("--wait")[0]);
+        if (args.is_present("--profile-hz"))
+            profile_hz = std::stoi(args.get_options("--profile-hz")[0]);
+        if (args.is_present("--freq-tolerance"))
+            freq_tolerance = std::stod(args.get_options("--freq-tolerance")[0]);
+        if (args.is_present("--check-block"))
+            opts.check_block = std::stoi(args.get_options("--check-block")[0]);
     } catch (...) {
         std::cerr << "Error parsing command-line arguments." << std::endl;
         return 1;
     }
+
+    std::vector<std::string> methods;
+    {
+        std::stringstream ss(method);
+        std::string token;
+        while (std::getline(ss, token, ',')) {
+            if (std::find(kMethods.begin(), kMethods.end(), token) == kMethods.end()) {
+                std::cerr << "Unknown method: " << token << std::endl;
+                return 1;
+            }
+            methods.push_back(token);
+        }
+    }
+    if (methods.empty()) {
+        std::cerr << "No valid methods provided." << std::endl;
+        return 1;
+    }
+    if (array_size < 0) {
+        std::cerr << "Array size must not be negative." << std::endl;
+        return 1;
+    }
+    if (density < 0.0 || density > 1.0) {
+        std::cerr << "Density must be between 0 and 1." << std::endl;
+        return 1;
+    }
+    if (opts.affinity != "fresh" && opts.affinity != "shared" && opts.affinity != "sticky") {
+        std::cerr << "Unknown affinity: " << opts.affinity << std::endl;
+        return 1;
+    }
+    if (opts.check_block <= 0) {
+        std::cerr << "Check block size must be positive." << std::endl;
+        return 1;
+    }
     
     // Parse thread counts (supporting comma-separated list)
     std::vector<int> thread_counts = parseThreadCounts(thread_option);
@@ -201,8 +5070,21 @@ int main(int argc, char* argv[]) {
     
     // Prepare the array
     std::vector<int> arr(array_size);
-    fillArray(arr, distribution);
-    std::cout << "Array of size " << array_size << " filled using distribution: " << distribution << std::endl;
+    fillArray(arr, distribution, density);
+    std::cout << "Array of size " << array_size << " filled using distribution: " << distribution;
+    if (distribution == "flags") std::cout << " (density " << density << ")";
+    std::cout << std::endl;
+    // The popcount methods count set bits of the array packed once into a bitmap
+    const bool counts_bits = std::any_of(methods.begin(), methods.end(), [](const std::string& m) { return m.rfind("popcount", 0) == 0; });
+    Bitmap bitmap;
+    if (counts_bits) {
+        bitmap = packFlags(arr);
+        opts.bitmap = &bitmap;
+    }
+    const CpuLimit cpu_limit = cgroupCpuLimit();
+    const double cpu_quota = cpu_limit.cores;
+    std::cout << "Default parallelism: " << defaultParallelism() << " (" << availableCores().size() << " CPUs in affinity mask, cgroup CPU quota: "
+              << (cpu_quota > 0 ? std::to_string(cpu_quota) + " cores in " + cpu_limit.dir.string() : std::string("none")) << ")" << std::endl;
     
     // Open CSV for output
     std::ofstream csv_file("results.csv");
@@ -210,112 +5092,266 @@ int main(int argc, char* argv[]) {
         std::cerr << "Failed to open results.csv for writing." << std::endl;
         return 1;
     }
-    csv_file << "Method,Threads,ArraySize,Run,Sum,Time_ms\n";
-    
-    // Loop through each specified thread count (for scalability experiments).
-    for (int n_threads : thread_counts) {
-        std::cout << "\n--- Running with " << n_threads << " thread(s) using method: " << method << " ---" << std::endl;
-        // For methods other than parallel, we use our thread pool.
+    csv_file << "Method,Threads,ArraySize,Run,Sum,Time_ms,Throttled,Freq_MHz,FreqSource,Governor,FreqDeviation\n";
+
+    // With --affinity shared|sticky one elastic pool serves the whole sweep and is resized per thread count.
+    std::unique_ptr<ThreadPool> sweep_pool;
+    auto poolFor = [&](int n_threads) -> ThreadPool* {
+        if (!sweep_pool) {
+            sweep_pool = makeRunPool(opts, n_threads);
+        } else if (sweep_pool->size() != static_cast<size_t>(n_threads)) {
+            const size_t from = sweep_pool->size();
+            auto start_time = std::chrono::high_resolution_clock::now();
+            sweep_pool->resize(n_threads);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            std::cout << "Resized pool from " << from << " to " << n_threads << " worker(s) in "
+                      << std::chrono::duration<double, std::micro>(end_time - start_time).count() << " us" << std::endl;
+        }
+        return sweep_pool.get();
+    };
+
+    // Runs the warm-up and timed runs of one configuration, logging each timed run; returns the run times.
+    int throttled_runs = 0;
+    int freq_deviations = 0;
+    auto timeRuns = [&](const std::string& method, int n_threads, std::ofstream& out) {
+        ThreadPool* pool = poolFor(n_threads);
         // For each configuration, perform warm-up runs first.
         for (int i = 0; i < warmup; ++i) {
-            if (method == "parallel") {
-                volatile int sum = parallel_sum(arr);
-                (void)sum;
-            } else if (method == "locked") {
-                std::atomic<int> total_atomic(0);
-                ThreadPool pool(n_threads);
-                int block = array_size / n_threads;
-                std::vector<std::future<void>> futures;
-                for (int t = 0; t < n_threads; ++t) {
-                    int start_index = t * block;
-                    int end_index = (t == n_threads - 1) ? array_size : (t + 1) * block;
-                    futures.push_back(pool.submit(locked_sum, std::ref(arr), start_index, end_index, std::ref(total_atomic)));
-                }
-                for(auto &f: futures) { f.get(); }
-            } else if (method == "unlocked") {
-                int total_unlocked = 0;
-                ThreadPool pool(n_threads);
-                int block = array_size / n_threads;
-                std::vector<std::future<void>> futures;
-                for (int t = 0; t < n_threads; ++t) {
-                    int start_index = t * block;
-                    int end_index = (t == n_threads - 1) ? array_size : (t + 1) * block;
-                    futures.push_back(pool.submit(unlocked_sum, std::ref(arr), start_index, end_index, std::ref(total_unlocked)));
-                }
-                for(auto &f: futures) { f.get(); }
-            } else if (method == "reduce") {
-                std::vector<int> partial_sums(n_threads, 0);
-                ThreadPool pool(n_threads);
-                int block = array_size / n_threads;
-                std::vector<std::future<void>> futures;
-                for (int t = 0; t < n_threads; ++t) {
-                    int start_index = t * block;
-                    int end_index = (t == n_threads - 1) ? array_size : (t + 1) * block;
-                    futures.push_back(pool.submit(reduce_sum, std::ref(arr), start_index, end_index, std::ref(partial_sums[t])));
-                }
-                for(auto &f: futures) { f.get(); }
-                volatile int s = std::accumulate(partial_sums.begin(), partial_sums.end(), 0);
-                (void)s;
-            }
+            volatile int sum = runMethod(method, arr, n_threads, opts, pool);
+            (void)sum;
         }
         
         // Now perform the timed runs.
+        std::vector<double> times, mhz;
+        std::vector<std::string> rows;
         for (int run = 0; run < runs; ++run) {
-            int sum_result = 0;
+            const ThrottleStats throttle_before = readThrottleStats();
+            // Cycle counting follows the threads created during the run, so it needs a fresh pool
+            std::unique_ptr<CycleCounter> cycles;
+            if (!pool) cycles = std::make_unique<CycleCounter>();
             auto start_time = std::chrono::high_resolution_clock::now();
-            if (method == "parallel") {
-                // Note: thread count is not used in parallel mode.
-                sum_result = parallel_sum(arr);
+            int sum_result = runMethod(method, arr, n_threads, opts, pool);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            const ThrottleStats throttle_after = readThrottleStats();
+            std::string freq_source = "perf";
+            double run_mhz = cycles ? cycles->effective_mhz() : 0.0;
+            if (run_mhz <= 0.0) run_mhz = sampledCpuMhz(freq_source);
+            mhz.push_back(run_mhz);
+            double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+            times.push_back(elapsed);
+            // CFS throttling during the run means the time reflects the CPU quota, not the method
+            const long long throttled = (throttle_before.valid() && throttle_after.valid())
+                                            ? throttle_after.nr_throttled - throttle_before.nr_throttled : 0;
+            std::cout << "Run " << run + 1 << " - Sum: " << sum_result << ", Time: " << elapsed << " ms";
+            if (throttled > 0) {
+                ++throttled_runs;
+                std::cout << " [THROTTLED: " << throttled << " period(s), "
+                          << throttle_after.throttled_ms - throttle_before.throttled_ms << " ms]";
             }
-            else if (method == "locked") {
-                std::atomic<int> total_atomic(0);
-                ThreadPool pool(n_threads);
-                int block = array_size / n_threads;
-                std::vector<std::future<void>> futures;
-                for (int t = 0; t < n_threads; ++t) {
-                    int start_index = t * block;
-                    int end_index = (t == n_threads - 1) ? array_size : (t + 1) * block;
-                    futures.push_back(pool.submit(locked_sum, std::ref(arr), start_index, end_index, std::ref(total_atomic)));
-                }
-                for(auto &f: futures) { f.get(); }
-                sum_result = total_atomic.load();
+            std::cout << std::endl;
+            // For the parallel method, record thread count as 0 (or "N/A")
+            std::ostringstream row;
+            row << method << "," << ((method=="parallel") ? 0 : n_threads) << ","
+                << array_size << "," << run + 1 << "," << sum_result << "," << elapsed << "," << throttled << ","
+                << run_mhz << "," << freq_source << "," << cpuGovernor();
+            rows.push_back(row.str());
+        }
+
+        // Runs whose effective frequency strays from the configuration's median measured turbo or
+        // thermal changes as much as the method
+        std::vector<double> measured;
+        std::copy_if(mhz.begin(), mhz.end(), std::back_inserter(measured), [](double f) { return f > 0.0; });
+        const double median_mhz = percentile(measured, 50);
+        for (int run = 0; run < runs; ++run) {
+            const double deviation = (median_mhz > 0 && mhz[run] > 0) ? mhz[run] / median_mhz - 1.0 : 0.0;
+            const bool flagged = std::abs(deviation) * 100.0 > freq_tolerance;
+            if (flagged) {
+                ++freq_deviations;
+                std::ostringstream note;
+                note << std::fixed << std::setprecision(0) << "Run " << run + 1 << " [FREQUENCY: " << mhz[run]
+                     << " MHz, " << std::showpos << std::setprecision(1) << deviation * 100.0 << std::noshowpos
+                     << "% from the median " << std::setprecision(0) << median_mhz << " MHz]";
+                std::cout << note.str() << std::endl;
             }
-            else if (method == "unlocked") {
-                int total_unlocked = 0;
-                ThreadPool pool(n_threads);
-                int block = array_size / n_threads;
-                std::vector<std::future<void>> futures;
-                for (int t = 0; t < n_threads; ++t) {
-                    int start_index = t * block;
-                    int end_index = (t == n_threads - 1) ? array_size : (t + 1) * block;
-                    futures.push_back(pool.submit(unlocked_sum, std::ref(arr), start_index, end_index, std::ref(total_unlocked)));
-                }
-                for(auto &f: futures) { f.get(); }
-                sum_result = total_unlocked;
+            out << rows[run] << "," << (flagged ? 1 : 0) << "\n";
+        }
+        return times;
+    };
+
+    // With --interference, every configuration is run a second time next to the noisy neighbours.
+    std::unique_ptr<Interference> interference;
+    std::ofstream interference_csv;
+    if (!interference_specs.empty()) {
+        interference = std::make_unique<Interference>(interference_specs);
+        interference_csv.open("interference_results.csv");
+        if (!interference_csv.is_open()) {
+            std::cerr << "Failed to open interference_results.csv for writing." << std::endl;
+            return 1;
+        }
+        interference_csv << "Method,Threads,ArraySize,Run,Sum,Time_ms,Throttled,Freq_MHz,FreqSource,Governor,FreqDeviation\n";
+    }
+    struct Degradation { std::string method; int threads; double quiet_p50, quiet_p99, noisy_p50, noisy_p99; };
+    std::vector<Degradation> degradations;
+    struct Throughput { std::string method; int threads; double p50_ms; };
+    std::vector<Throughput> throughputs;
+    
+    // With --checked, every method and thread count is also run with its checked variant, and its cost is reported.
+    const bool checked = args.is_present("--checked");
+    std::ofstream checked_csv;
+    if (checked) {
+        checked_csv.open("checked_results.csv");
+        if (!checked_csv.is_open()) {
+            std::cerr << "Failed to open checked_results.csv for writing." << std::endl;
+            return 1;
+        }
+        checked_csv << "Method,Threads,ArraySize,Block,Run,Time_ms,ExactSum,FirstOverflowBlock\n";
+    }
+    struct CheckCost { std::string method; int threads; double unchecked_p50, checked_p50; long long first_overflow_block; };
+    std::vector<CheckCost> check_costs;
+    // A checked total must equal the exact 64-bit sum (the non-zero count for popcount); a mismatch fails the run.
+    // "unlocked" races by design and is not compared.
+    const long long exact_sum = checked ? std::accumulate(arr.begin(), arr.end(), 0LL) : 0;
+    const long long nonzero = checked ? std::count_if(arr.begin(), arr.end(), [](int v) { return v != 0; }) : 0;
+    bool checked_mismatch = false;
+    auto timeCheckedRuns = [&](const std::string& method, int n_threads) {
+        ThreadPool* pool = poolFor(n_threads);
+        CheckedSum result;
+        for (int i = 0; i < warmup; ++i) {
+            volatile int sum = runMethod(method, arr, n_threads, opts, pool, &result);
+            (void)sum;
+        }
+        std::vector<double> times;
+        for (int run = 0; run < runs; ++run) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            runMethod(method, arr, n_threads, opts, pool, &result);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            const double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+            times.push_back(elapsed);
+            checked_csv << method << "," << ((method == "parallel") ? 0 : n_threads) << "," << array_size << "," << opts.check_block << ","
+                        << run + 1 << "," << elapsed << "," << result.total << "," << result.first_overflow_block << "\n";
+        }
+        const long long reference = method.rfind("popcount", 0) == 0 ? nonzero : exact_sum;
+        if (runs > 0 && method != "unlocked" && result.total != reference) {
+            std::cerr << "Checked " << method << " mismatch (" << n_threads << " thread(s)): got " << result.total
+                      << ", expected " << reference << std::endl;
+            checked_mismatch = true;
+        }
+        std::cout << "Checked: sum " << result.total << ", p50 " << percentile(times, 50) << " ms";
+        if (result.overflowed()) {
+            const long long start_index = result.first_overflow_block * opts.check_block;
+            std::cout << " [OVERFLOW: the int running total leaves int range in block " << result.first_overflow_block
+                      << " (elements " << start_index << ".." << std::min<long long>(array_size, start_index + opts.check_block) - 1
+                      << "); the unchecked sum has wrapped]";
+        }
+        std::cout << std::endl;
+        return std::make_pair(percentile(times, 50), result.first_overflow_block);
+    };
+
+    // With --profile, each method's runs are sampled into profile_<method>.folded.
+    // Enabled before any pool of the runs exists, so every worker registers; without --profile they skip it.
+    const bool profile = args.is_present("--profile");
+    if (profile) SamplingProfiler::enable();
+    std::unique_ptr<ProfiledThread> profiled_main;
+    if (profile) profiled_main = std::make_unique<ProfiledThread>();
+
+    // Loop through each method and each specified thread count (for scalability experiments).
+    for (const std::string& method : methods) {
+        const bool profiling = profile && SamplingProfiler::start(profile_hz, 1 << 16);
+        if (profile && !profiling)
+            std::cerr << "Warning: the sampling profiler is not available on this platform" << std::endl;
+        for (int n_threads : thread_counts) {
+            std::cout << "\n--- Running with " << n_threads << " thread(s) using method: " << method << " ---" << std::endl;
+            std::vector<double> quiet = timeRuns(method, n_threads, csv_file);
+            throughputs.push_back({method, n_threads, percentile(quiet, 50)});
+            if (checked) {
+                const auto [checked_p50, first_overflow_block] = timeCheckedRuns(method, n_threads);
+                check_costs.push_back({method, n_threads, percentile(quiet, 50), checked_p50, first_overflow_block});
             }
-            else if (method == "reduce") {
-                std::vector<int> partial_sums(n_threads, 0);
-                ThreadPool pool(n_threads);
-                int block = array_size / n_threads;
-                std::vector<std::future<void>> futures;
-                for (int t = 0; t < n_threads; ++t) {
-                    int start_index = t * block;
-                    int end_index = (t == n_threads - 1) ? array_size : (t + 1) * block;
-                    futures.push_back(pool.submit(reduce_sum, std::ref(arr), start_index, end_index, std::ref(partial_sums[t])));
-                }
-                for(auto &f: futures) { f.get(); }
-                sum_result = std::accumulate(partial_sums.begin(), partial_sums.end(), 0);
+            if (interference) {
+                std::cout << "--- Same configuration under interference: " << interference->describe() << " ---" << std::endl;
+                interference->start();
+                std::vector<double> noisy = timeRuns(method, n_threads, interference_csv);
+                interference->stop();
+                degradations.push_back({method, n_threads, percentile(quiet, 50), percentile(quiet, 99),
+                                        percentile(noisy, 50), percentile(noisy, 99)});
             }
-            auto end_time = std::chrono::high_resolution_clock::now();
-            long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            std::cout << "Run " << run + 1 << " - Sum: " << sum_result << ", Time: " << elapsed << " ms" << std::endl;
-            // For the parallel method, record thread count as 0 (or "N/A")
-            csv_file << method << "," << ((method=="parallel") ? 0 : n_threads) << "," 
-                     << array_size << "," << run + 1 << "," << sum_result << "," << elapsed << "\n";
         }
+        if (profiling) {
+            const ProfileReport report = SamplingProfiler::stop();
+            const std::string folded = "profile_" + method + ".folded";
+            if (!SamplingProfiler::write_folded(folded, method))
+                std::cerr << "Failed to open " << folded << " for writing." << std::endl;
+            std::cout << "Profile: " << report.samples << " samples (" << report.dropped << " dropped) at " << profile_hz
+                      << " Hz written to " << folded << "; handler overhead " << std::fixed << std::setprecision(3)
+                      << (report.sampled_cpu_ms > 0 ? report.handler_ms / report.sampled_cpu_ms * 100.0 : 0.0)
+                      << "% of sampled CPU time" << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+        }
+    }
+
+    if (interference) {
+        std::cout << "\n--- Degradation under interference (" << interference->describe() << ") ---" << std::endl;
+        std::cout << std::left << std::setw(14) << "Method" << std::right << std::setw(8) << "Threads"
+                  << std::setw(12) << "p50 quiet" << std::setw(12) << "p50 noisy" << std::setw(12) << "Throughput"
+                  << std::setw(12) << "p99 quiet" << std::setw(12) << "p99 noisy" << std::setw(10) << "p99 x" << std::endl;
+        for (const Degradation& d : degradations) {
+            std::cout << std::left << std::setw(14) << d.method << std::right << std::setw(8) << d.threads
+                      << std::fixed << std::setprecision(3)
+                      << std::setw(12) << d.quiet_p50 << std::setw(12) << d.noisy_p50
+                      << std::setw(11) << std::setprecision(1) << (d.quiet_p50 / d.noisy_p50) * 100.0 << "%"
+                      << std::setprecision(3) << std::setw(12) << d.quiet_p99 << std::setw(12) << d.noisy_p99
+                      << std::setw(9) << std::setprecision(2) << d.noisy_p99 / d.quiet_p99 << "x" << std::endl;
+        }
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << "(Throughput is the fraction of quiet throughput retained under interference; times in ms)" << std::endl;
+        interference_csv.close();
+        std::cout << "Contended runs written to interference_results.csv" << std::endl;
+    }
+    
+    if (counts_bits) {
+        // Every method counts the same flags, stored as one int or one bit each
+        std::cout << "\n--- Flag counting throughput (" << array_size << " flags, " << bitmap.words.size() * sizeof(uint64_t)
+                  << " bytes as bitmap, " << arr.size() * sizeof(int) << " bytes as int) ---" << std::endl;
+        std::cout << std::left << std::setw(14) << "Method" << std::right << std::setw(8) << "Threads"
+                  << std::setw(12) << "p50 ms" << std::setw(14) << "Gbit/s" << std::setw(12) << "GB/s" << std::endl;
+        for (const Throughput& t : throughputs) {
+            const bool packed = t.method.rfind("popcount", 0) == 0;
+            const double bytes = packed ? bitmap.words.size() * sizeof(uint64_t) : arr.size() * sizeof(int);
+            std::cout << std::left << std::setw(14) << t.method << std::right << std::setw(8) << t.threads
+                      << std::fixed << std::setprecision(3) << std::setw(12) << t.p50_ms
+                      << std::setw(14) << array_size / (t.p50_ms * 1e6) << std::setw(12) << bytes / (t.p50_ms * 1e6) << std::endl;
+        }
+        std::cout.unsetf(std::ios::floatfield);
+        if (distribution != "flags")
+            std::cout << "(Without --dist flags the popcount methods count non-zero elements, not the sum)" << std::endl;
+    }
+
+    if (checked) {
+        std::cout << "\n--- Cost of overflow checking (" << opts.check_block << "-element blocks) ---" << std::endl;
+        std::cout << std::left << std::setw(14) << "Method" << std::right << std::setw(8) << "Threads" << std::setw(14) << "unchecked ms"
+                  << std::setw(12) << "checked ms" << std::setw(10) << "Cost" << std::setw(16) << "First overflow" << std::endl;
+        for (const CheckCost& c : check_costs) {
+            std::cout << std::left << std::setw(14) << c.method << std::right << std::setw(8) << c.threads << std::fixed
+                      << std::setprecision(3) << std::setw(14) << c.unchecked_p50 << std::setw(12) << c.checked_p50
+                      << std::showpos << std::setprecision(1) << std::setw(9) << (c.checked_p50 / c.unchecked_p50 - 1.0) * 100.0
+                      << std::noshowpos << "%" << std::setw(16)
+                      << (c.first_overflow_block >= 0 ? "block " + std::to_string(c.first_overflow_block) : std::string("none")) << std::endl;
+        }
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << "Checked runs written to checked_results.csv" << std::endl;
+    }
+
+    if (freq_deviations > 0) {
+        std::cout << "\nWarning: " << freq_deviations << " run(s) ran more than " << freq_tolerance
+                  << "% away from their configuration's median CPU frequency (see the FreqDeviation column)." << std::endl;
+    }
+
+    if (throttled_runs > 0) {
+        std::cout << "\nWarning: " << throttled_runs << " run(s) were CFS-throttled by the cgroup CPU quota"
+                  << " (see the Throttled column); consider fewer threads." << std::endl;
     }
     
     csv_file.close();
     std::cout << "\nResults written to results.csv" << std::endl;
-    return 0;
+    return checked_mismatch ? 1 : 0;
 }
@@ -0,0 +1,19 @@
+# PGO training sweep, run by the pgo_train target: cmake -DSUM_EXPERIMENT=<binary> -P pgo_train.cmake
+# The methods come from the binary's --list-methods, so the sweep covers every method runMethod accepts.
+execute_process(COMMAND ${SUM_EXPERIMENT} --list-methods
+                OUTPUT_VARIABLE methods
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${SUM_EXPERIMENT} --list-methods failed")
+endif()
+string(REGEX REPLACE "\n$" "" methods "${methods}")
+string(REPLACE "\n" ";" methods "${methods}")
+foreach(method ${methods})
+    message(STATUS "Training ${method}")
+    execute_process(COMMAND ${SUM_EXPERIMENT} --threads 1,2,4,8 --size 4000000 --method ${method} --runs 3 --warmup 1 --dist rand
+                    OUTPUT_QUIET
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "PGO training run for ${method} failed")
+    endif()
+endforeach()